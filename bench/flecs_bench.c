@@ -0,0 +1,392 @@
+// Flecs microbenchmarks.
+//
+// Measures the ECS hot paths the game leans on, each at 1k, 10k, 100k, 1M and
+// 10M entities, so changes to lib/flecs can be judged by numbers:
+//
+//      entity.create_delete_N      create N entities, then delete them
+//      entity.add_remove_N         add and remove a component on N entities
+//      query.cached_N              iterate N entities with a cached query
+//      query.uncached_N            the same with an uncached query
+//      query.order_by_resort_N     change the sort key of N entities and iterate sorted
+//      query.order_by_iter_N       iterate N already sorted entities
+//      query.order_by_key_resort_N the resort benchmark with an order_by_key radix sort
+//      observer.on_set_N           set a component observed by one observer on N entities
+//      commands.merge_N            add and remove a tag on N entities while deferred
+//      pipeline.progress_N         ecs_progress with one system over N entities
+//      pipeline.progress_mt_N      the same on BENCH_THREADS worker threads
+//      pipeline.progress_atomic_N  the same with EcsWorkerSyncAtomic worker sync
+//      pipeline.progress_steal_N   the same with a work stealing system
+//
+// One iteration is one full pass over the N entities. Each benchmark builds a
+// fresh world on its first sample and keeps it for the rest, so the 10M runs
+// pay their setup once. Build with optimizations and pick benchmarks with the
+// usual rktest options:
+//
+//      cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target flecs_bench
+//      ./build/flecs_bench --rktest_filter=query.*_1M --rktest_bench_counters
+
+#define DEFINE_RKTEST_IMPLEMENTATION
+#include <rktest/rktest.h>
+
+#include <flecs/flecs.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_TABLES 8              // Entities are spread over this many archetypes
+#define BENCH_THREADS 4
+
+typedef struct Position {
+    float x;
+    float y;
+} Position;
+
+typedef struct Velocity {
+    float x;
+    float y;
+} Velocity;
+
+typedef struct Mass {
+    float value;
+} Mass;
+
+ECS_COMPONENT_DECLARE(Position);
+ECS_COMPONENT_DECLARE(Velocity);
+ECS_COMPONENT_DECLARE(Mass);
+
+// World shared by the samples of one benchmark, freed by the suite teardown
+typedef struct BenchFixture {
+    ecs_world_t *world;
+    ecs_entity_t *entities;
+    size_t count;
+    ecs_entity_t tags[BENCH_TABLES];
+    ecs_entity_t extraTag;
+    ecs_query_t *query;
+    ecs_query_t *writer;
+    ecs_entity_t observer;
+    ecs_entity_t system;
+    uint32_t seed;
+} BenchFixture;
+
+static BenchFixture fixture;
+static volatile float sink;         // Keeps iteration results alive
+
+static float bench_random(void)
+{
+    fixture.seed = fixture.seed * 1664525u + 1013904223u;
+    return (float)(fixture.seed >> 8) / 16777216.0f;
+}
+
+// Creates the world with `count` entities that have Position, Velocity and one
+// of BENCH_TABLES tags, or returns the one made by an earlier sample.
+static ecs_world_t *bench_world(size_t count)
+{
+    if (fixture.world) {
+        return fixture.world;
+    }
+
+    ecs_world_t *world = ecs_init();
+    ECS_COMPONENT_DEFINE(world, Position);
+    ECS_COMPONENT_DEFINE(world, Velocity);
+    ECS_COMPONENT_DEFINE(world, Mass);
+
+    for (int i = 0; i < BENCH_TABLES; i++) {
+        fixture.tags[i] = ecs_new(world);
+    }
+    fixture.extraTag = ecs_new(world);
+
+    fixture.world = world;
+    fixture.count = count;
+    fixture.seed = 1;
+    fixture.entities = malloc((count ? count : 1) * sizeof(ecs_entity_t));
+
+    size_t created = 0;
+    for (int t = 0; t < BENCH_TABLES; t++) {
+        size_t tableCount = count / BENCH_TABLES + ((size_t)t < count % BENCH_TABLES);
+        if (!tableCount) {
+            continue;
+        }
+
+        const ecs_entity_t *entities = ecs_bulk_init(world, &(ecs_bulk_desc_t){
+            .count = (int32_t)tableCount,
+            .ids = { ecs_id(Position), ecs_id(Velocity), fixture.tags[t] }
+        });
+        memcpy(fixture.entities + created, entities, tableCount * sizeof(ecs_entity_t));
+        created += tableCount;
+    }
+
+    // Bulk created components aren't initialized
+    ecs_query_t *init = ecs_query(world, {
+        .terms = {{ ecs_id(Position), .inout = EcsOut }, { ecs_id(Velocity), .inout = EcsOut }}
+    });
+    ecs_iter_t it = ecs_query_iter(world, init);
+    while (ecs_query_next(&it)) {
+        Position *p = ecs_field(&it, Position, 0);
+        Velocity *v = ecs_field(&it, Velocity, 1);
+        for (int i = 0; i < it.count; i++) {
+            p[i] = (Position){ bench_random(), bench_random() };
+            v[i] = (Velocity){ 1.0f, 1.0f };
+        }
+    }
+    ecs_query_fini(init);
+
+    return world;
+}
+
+static void bench_fixture_fini(void)
+{
+    if (fixture.query) {
+        ecs_query_fini(fixture.query);
+    }
+    if (fixture.writer) {
+        ecs_query_fini(fixture.writer);
+    }
+    if (fixture.world) {
+        ecs_fini(fixture.world);
+    }
+
+    free(fixture.entities);
+    fixture = (BenchFixture){ 0 };
+}
+
+// Sum over the query so the iteration can't be optimized away
+static void bench_iterate(ecs_query_t *query)
+{
+    float sum = 0.0f;
+    ecs_iter_t it = ecs_query_iter(fixture.world, query);
+    while (ecs_query_next(&it)) {
+        const Position *p = ecs_field(&it, Position, 0);
+        const Velocity *v = ecs_field(&it, Velocity, 1);
+        for (int i = 0; i < it.count; i++) {
+            sum += p[i].x * v[i].x + p[i].y * v[i].y;
+        }
+    }
+    sink = sum;
+}
+
+static int ComparePosition(ecs_entity_t e1, const void *ptr1, ecs_entity_t e2, const void *ptr2)
+{
+    (void)e1;
+    (void)e2;
+    const Position *p1 = ptr1;
+    const Position *p2 = ptr2;
+
+    return (p1->x > p2->x) - (p1->x < p2->x);
+}
+
+static uint64_t KeyPosition(ecs_entity_t e, const void *ptr)
+{
+    (void)e;
+    const Position *p = ptr;
+
+    return ecs_order_by_key_f32(p->x);
+}
+
+static void Move(ecs_iter_t *it)
+{
+    Position *p = ecs_field(it, Position, 0);
+    const Velocity *v = ecs_field(it, Velocity, 1);
+
+    for (int i = 0; i < it->count; i++) {
+        p[i].x += v[i].x * it->delta_time;
+        p[i].y += v[i].y * it->delta_time;
+    }
+}
+
+static void CountSets(ecs_iter_t *it)
+{
+    sink += (float)it->count;
+}
+
+static void bench_create_delete(size_t count)
+{
+    ecs_world_t *world = bench_world(0);
+    if (fixture.count < count) {
+        fixture.entities = realloc(fixture.entities, count * sizeof(ecs_entity_t));
+        fixture.count = count;
+    }
+
+    BENCHMARK_LOOP {
+        for (size_t i = 0; i < count; i++) {
+            fixture.entities[i] = ecs_new_w_id(world, ecs_id(Position));
+        }
+        for (size_t i = 0; i < count; i++) {
+            ecs_delete(world, fixture.entities[i]);
+        }
+    }
+}
+
+static void bench_add_remove(size_t count)
+{
+    ecs_world_t *world = bench_world(count);
+
+    BENCHMARK_LOOP {
+        for (size_t i = 0; i < count; i++) {
+            ecs_add(world, fixture.entities[i], Mass);
+        }
+        for (size_t i = 0; i < count; i++) {
+            ecs_remove(world, fixture.entities[i], Mass);
+        }
+    }
+}
+
+static void bench_query(size_t count, ecs_query_cache_kind_t cacheKind)
+{
+    ecs_world_t *world = bench_world(count);
+    if (!fixture.query) {
+        fixture.query = ecs_query(world, {
+            .terms = {{ ecs_id(Position), .inout = EcsIn }, { ecs_id(Velocity), .inout = EcsIn }},
+            .cache_kind = cacheKind
+        });
+    }
+
+    BENCHMARK_LOOP {
+        bench_iterate(fixture.query);
+    }
+}
+
+static void bench_order_by(size_t count, bool resort, bool key)
+{
+    ecs_world_t *world = bench_world(count);
+    if (!fixture.query) {
+        fixture.query = ecs_query(world, {
+            .terms = {{ ecs_id(Position), .inout = EcsIn }, { ecs_id(Velocity), .inout = EcsIn }},
+            .order_by = ecs_id(Position),
+            .order_by_callback = ComparePosition,
+            .order_by_key = key ? KeyPosition : NULL
+        });
+        fixture.writer = ecs_query(world, {
+            .terms = {{ ecs_id(Position), .inout = EcsInOut }},
+            .cache_kind = EcsQueryCacheAuto
+        });
+        bench_iterate(fixture.query);
+    }
+
+    BENCHMARK_LOOP {
+        // Writing through a query marks the column dirty, which triggers the sort
+        if (resort) {
+            ecs_iter_t it = ecs_query_iter(world, fixture.writer);
+            while (ecs_query_next(&it)) {
+                Position *p = ecs_field(&it, Position, 0);
+                for (int i = 0; i < it.count; i++) {
+                    p[i].x = bench_random();
+                }
+            }
+        }
+
+        bench_iterate(fixture.query);
+    }
+}
+
+static void bench_observer(size_t count)
+{
+    ecs_world_t *world = bench_world(count);
+    if (!fixture.observer) {
+        fixture.observer = ecs_observer(world, {
+            .query.terms = {{ ecs_id(Position) }},
+            .events = { EcsOnSet },
+            .callback = CountSets
+        });
+    }
+
+    BENCHMARK_LOOP {
+        for (size_t i = 0; i < count; i++) {
+            ecs_set(world, fixture.entities[i], Position, { 1.0f, 2.0f });
+        }
+    }
+}
+
+static void bench_merge(size_t count)
+{
+    ecs_world_t *world = bench_world(count);
+
+    BENCHMARK_LOOP {
+        ecs_defer_begin(world);
+        for (size_t i = 0; i < count; i++) {
+            ecs_add_id(world, fixture.entities[i], fixture.extraTag);
+        }
+        ecs_defer_end(world);
+
+        ecs_defer_begin(world);
+        for (size_t i = 0; i < count; i++) {
+            ecs_remove_id(world, fixture.entities[i], fixture.extraTag);
+        }
+        ecs_defer_end(world);
+    }
+}
+
+static void bench_progress(size_t count, int threads, ecs_worker_sync_t sync, bool steal)
+{
+    ecs_world_t *world = bench_world(count);
+    if (!fixture.system) {
+        fixture.system = ecs_system(world, {
+            .entity = ecs_entity(world, { .name = "Move", .add = ecs_ids(ecs_dependson(EcsOnUpdate)) }),
+            .query.terms = {{ ecs_id(Position) }, { ecs_id(Velocity), .inout = EcsIn }},
+            .callback = Move,
+            .multi_threaded = threads > 1,
+            .work_stealing = steal
+        });
+        if (threads > 1) {
+            ecs_set_worker_sync(world, sync);
+            ecs_set_threads(world, threads);
+        }
+    }
+
+    BENCHMARK_LOOP {
+        ecs_progress(world, 1.0f / 60.0f);
+    }
+}
+
+// Registers SUITE.NAME_<count> for each entity count, calling BENCH(count)
+#define BENCH_SIZES(SUITE, NAME, BENCH)                         \
+    BENCHMARK(SUITE, NAME##_1k) { BENCH(1000); }                \
+    BENCHMARK(SUITE, NAME##_10k) { BENCH(10000); }              \
+    BENCHMARK(SUITE, NAME##_100k) { BENCH(100000); }            \
+    BENCHMARK(SUITE, NAME##_1M) { BENCH(1000000); }             \
+    BENCHMARK(SUITE, NAME##_10M) { BENCH(10000000); }
+
+#define bench_cached(count) bench_query(count, EcsQueryCacheAuto)
+#define bench_uncached(count) bench_query(count, EcsQueryCacheNone)
+#define bench_order_by_resort(count) bench_order_by(count, true, false)
+#define bench_order_by_iter(count) bench_order_by(count, false, false)
+#define bench_order_by_key_resort(count) bench_order_by(count, true, true)
+#define bench_progress_st(count) bench_progress(count, 1, EcsWorkerSyncMutex, false)
+#define bench_progress_mt(count) bench_progress(count, BENCH_THREADS, EcsWorkerSyncMutex, false)
+#define bench_progress_atomic(count) bench_progress(count, BENCH_THREADS, EcsWorkerSyncAtomic, false)
+#define bench_progress_steal(count) bench_progress(count, BENCH_THREADS, EcsWorkerSyncAtomic, true)
+
+BENCH_SIZES(entity, create_delete, bench_create_delete)
+BENCH_SIZES(entity, add_remove, bench_add_remove)
+BENCH_SIZES(query, cached, bench_cached)
+BENCH_SIZES(query, uncached, bench_uncached)
+BENCH_SIZES(query, order_by_resort, bench_order_by_resort)
+BENCH_SIZES(query, order_by_iter, bench_order_by_iter)
+BENCH_SIZES(query, order_by_key_resort, bench_order_by_key_resort)
+BENCH_SIZES(observer, on_set, bench_observer)
+BENCH_SIZES(commands, merge, bench_merge)
+BENCH_SIZES(pipeline, progress, bench_progress_st)
+BENCH_SIZES(pipeline, progress_mt, bench_progress_mt)
+BENCH_SIZES(pipeline, progress_atomic, bench_progress_atomic)
+BENCH_SIZES(pipeline, progress_steal, bench_progress_steal)
+
+TEST_TEARDOWN(entity) { bench_fixture_fini(); }
+TEST_TEARDOWN(query) { bench_fixture_fini(); }
+TEST_TEARDOWN(observer) { bench_fixture_fini(); }
+TEST_TEARDOWN(commands) { bench_fixture_fini(); }
+TEST_TEARDOWN(pipeline) { bench_fixture_fini(); }
+
+int main(int argc, const char *argv[])
+{
+    // Everything here is a benchmark, so always run in benchmark mode
+    const char **args = malloc((size_t)(argc + 1) * sizeof(char *));
+    args[0] = argv[0];
+    args[1] = "--rktest_bench";
+    for (int i = 1; i < argc; i++) {
+        args[i + 1] = argv[i];
+    }
+
+    int result = rktest_main(argc + 1, args);
+    free(args);
+
+    return result;
+}
@@ -662,6 +662,11 @@ void flecs_type_free(
     ecs_world_t *world,
     ecs_type_t *type);
 
+/** Find index of id in type. Only matches the exact id, no wildcards. */
+int32_t flecs_type_index_of(
+    const ecs_type_t *type,
+    ecs_id_t id);
+
 /* Find table by removing id from current table */
 ecs_table_t *flecs_table_traverse_remove(
     ecs_world_t *world,
@@ -861,7 +866,7 @@ struct ecs_table_t {
     ecs_flags32_t flags;             /* Flags for testing table properties */
     int16_t column_count;            /* Number of components (excluding tags) */
     uint16_t version;                /* Version of table */
-    uint64_t bloom_filter;           /* For quick matching with queries */
+    uint64_t bloom_filter[FLECS_BLOOM_FILTER_WORDS]; /* For quick matching with queries */
     ecs_type_t type;                 /* Vector with component ids */
 
     ecs_data_t data;                 /* Component storage */
@@ -973,6 +978,13 @@ void flecs_table_swap(
     int32_t row_1,
     int32_t row_2);
 
+/* Reorder all rows of a table. Row i gets the contents of row order[i]. Doesn't
+ * mark the table dirty. */
+void flecs_table_permute(
+    ecs_world_t *world,
+    ecs_table_t *table,
+    const int32_t *order);
+
 void flecs_table_mark_dirty(
     ecs_world_t *world,
     ecs_table_t *table,
@@ -1010,13 +1022,21 @@ ecs_id_t flecs_column_id(
     ecs_table_t *table,
     int32_t column_index);
 
-uint64_t flecs_table_bloom_filter_add(
-    uint64_t filter,
+/* Get table record for id. Same result as flecs_component_get_table, but
+ * looks up non-wildcard ids in the table type, which doesn't require fetching
+ * the component record. */
+const ecs_table_record_t* flecs_table_get_record(
+    const ecs_world_t *world,
+    const ecs_table_t *table,
+    ecs_id_t id);
+
+void flecs_table_bloom_filter_add(
+    uint64_t *filter,
     uint64_t value);
 
 bool flecs_table_bloom_filter_test(
     const ecs_table_t *table,
-    uint64_t filter);
+    const uint64_t *filter);
 
 const ecs_ref_t* flecs_table_get_override(
     ecs_world_t *world,
@@ -1683,6 +1703,7 @@ typedef struct ecs_query_cache_t {
     ecs_entity_t order_by;
     ecs_order_by_action_t order_by_callback;
     ecs_sort_table_action_t order_by_table_callback;
+    ecs_order_by_key_action_t order_by_key;
     ecs_vec_t table_slices;
     int32_t order_by_term;
 
@@ -1704,6 +1725,10 @@ typedef struct ecs_query_cache_t {
     
     ecs_entity_t entity;             /* Entity associated with query */
 
+    /* Id the cache is registered with in the world query index, or 0 if the
+     * cache is matched with new tables by its observer. */
+    ecs_id_t index_id;
+
     /* Zero'd out sources array, used for results that only match on $this */
     ecs_entity_t *sources;
 
@@ -1734,6 +1759,11 @@ bool flecs_query_cache_is_trivial(
 ecs_size_t flecs_query_cache_elem_size(
     const ecs_query_cache_t *cache);
 
+/* Match new table with the caches in the world query index */
+void flecs_query_cache_match_new_table(
+    ecs_world_t *world,
+    ecs_table_t *table);
+
 /**
  * @file query/cache/cache_iter.h
  * @brief Cache iterator functions.
@@ -3231,6 +3261,7 @@ struct ecs_stage_t {
     ecs_world_t *thread_ctx;         /* Points to stage when a thread stage */
     ecs_world_t *world;              /* Reference to world */
     ecs_os_thread_t thread;          /* Thread handle (0 if no threading is used) */
+    int32_t sync_spin;               /* Spin budget for EcsWorkerSyncAtomic, 0 if unset */
 
     /* One-shot actions to be executed after the merge */
     ecs_vec_t post_frame_actions;
@@ -3419,6 +3450,9 @@ struct ecs_world_t {
     /* Used to track when cache needs to be updated */
     ecs_monitor_set_t monitors;      /* map<id, ecs_monitor_t> */
 
+    /* Query caches that new tables are only matched with if they have the id */
+    ecs_map_t query_index;           /* map<id, vector<ecs_query_cache_t*>> */
+
     /* -- Systems -- */
     ecs_entity_t pipeline;           /* Current pipeline */
 
@@ -3445,9 +3479,16 @@ struct ecs_world_t {
     /* -- Multithreading -- */
     ecs_os_cond_t worker_cond;       /* Signal that worker threads can start */
     ecs_os_cond_t sync_cond;         /* Signal that worker thread job is done */
+    ecs_os_cond_t park_cond;         /* Signal for threads parked on a counter without futex */
     ecs_os_mutex_t sync_mutex;       /* Mutex for job_cond */
     int32_t workers_running;         /* Number of threads running */
     int32_t workers_waiting;         /* Number of workers waiting on sync */
+    int32_t worker_sync;             /* ecs_worker_sync_t */
+    int32_t sync_epoch;              /* Incremented to release workers */
+    int32_t sync_sleepers;           /* Threads parked on a sync counter */
+    int32_t *worker_cpus;            /* CPUs to pin workers to, see ecs_set_worker_affinity */
+    int32_t worker_cpu_count;
+    int32_t worker_cpus_per_thread;
     ecs_pipeline_state_t* pq;        /* Pointer to the pipeline for the workers to execute */
     bool workers_use_task_api;       /* Workers are short-lived tasks, not long-running threads */
 
@@ -5900,10 +5941,220 @@ bool flecs_remove_invalid(
     return true;
 }
 
+/* Command kind and id, used to compare the commands of two entities */
+typedef struct ecs_cmd_batch_key_t {
+    ecs_cmd_kind_t kind;
+    ecs_id_t id;
+} ecs_cmd_batch_key_t;
+
+/* Result of the last batch that only added/set components. Commands are often
+ * enqueued for many entities of the same kind (for example when spawning), in
+ * which case the next entity with the same start table and the same commands
+ * can reuse the destination table and diff instead of walking the table graph
+ * and revalidating ids for every command. */
+typedef struct ecs_cmd_batch_cache_t {
+    ecs_table_t *src;
+    ecs_table_t *dst;
+    ecs_vec_t keys;                  /* vector<ecs_cmd_batch_key_t> */
+    ecs_table_diff_builder_t diff;
+
+    /* Deleting tables or ids can invalidate the cached tables and ids */
+    int64_t table_delete_total;
+    int64_t id_delete_total;
+} ecs_cmd_batch_cache_t;
+
+static
+void flecs_cmd_batch_cache_init(
+    ecs_world_t *world,
+    ecs_cmd_batch_cache_t *cache)
+{
+    ecs_allocator_t *a = &world->allocator;
+    cache->src = NULL;
+    cache->dst = NULL;
+    ecs_vec_init_t(a, &cache->keys, ecs_cmd_batch_key_t, 0);
+    ecs_vec_init_t(a, &cache->diff.added, ecs_id_t, 0);
+    ecs_vec_init_t(a, &cache->diff.removed, ecs_id_t, 0);
+}
+
+static
+void flecs_cmd_batch_cache_fini(
+    ecs_world_t *world,
+    ecs_cmd_batch_cache_t *cache)
+{
+    ecs_vec_fini_t(&world->allocator, &cache->keys, ecs_cmd_batch_key_t);
+    flecs_table_diff_builder_fini(world, &cache->diff);
+}
+
+/* Add command to the key of the batch that's being built. Returns false if the
+ * command can't be part of a cached batch. */
+static
+bool flecs_cmd_batch_cache_push(
+    ecs_world_t *world,
+    ecs_cmd_batch_cache_t *cache,
+    ecs_cmd_t *cmd)
+{
+    switch(cmd->kind) {
+    case EcsCmdAdd:
+    case EcsCmdAddModified:
+    case EcsCmdSet:
+    case EcsCmdEnsure:
+    case EcsCmdModified:
+    case EcsCmdModifiedNoHook:
+        break;
+    case EcsCmdRemove:
+    case EcsCmdClone:
+    case EcsCmdEmplace:
+    case EcsCmdBulkNew:
+    case EcsCmdPath:
+    case EcsCmdDelete:
+    case EcsCmdClear:
+    case EcsCmdOnDeleteAction:
+    case EcsCmdEnable:
+    case EcsCmdDisable:
+    case EcsCmdEvent:
+    case EcsCmdSkip:
+    default:
+        return false;
+    }
+
+    if (!cmd->id) {
+        return false;
+    }
+
+    ecs_cmd_batch_key_t *key = ecs_vec_append_t(
+        &world->allocator, &cache->keys, ecs_cmd_batch_key_t);
+    key->kind = cmd->kind;
+    key->id = cmd->id;
+    return true;
+}
+
+/* Store result of batch. Only done if all ids of the batch ended up in the
+ * destination table: as long as that table isn't deleted, the ids are valid. */
+static
+void flecs_cmd_batch_cache_set(
+    ecs_world_t *world,
+    ecs_cmd_batch_cache_t *cache,
+    ecs_table_t *src,
+    ecs_table_t *dst,
+    ecs_table_diff_builder_t *diff)
+{
+    int32_t i, count = ecs_vec_count(&cache->keys);
+    ecs_cmd_batch_key_t *keys = ecs_vec_first(&cache->keys);
+    for (i = 0; i < count; i ++) {
+        if (ecs_table_get_type_index(world, dst, keys[i].id) == -1) {
+            return;
+        }
+    }
+
+    ecs_allocator_t *a = &world->allocator;
+    ecs_vec_set_count_t(a, &cache->diff.added, ecs_id_t, diff->added.count);
+    ecs_vec_set_count_t(a, &cache->diff.removed, ecs_id_t, diff->removed.count);
+    if (diff->added.count) {
+        ecs_os_memcpy_n(cache->diff.added.array, diff->added.array, 
+            ecs_id_t, diff->added.count);
+    }
+    if (diff->removed.count) {
+        ecs_os_memcpy_n(cache->diff.removed.array, diff->removed.array, 
+            ecs_id_t, diff->removed.count);
+    }
+    cache->diff.added_flags = diff->added_flags;
+    cache->diff.removed_flags = diff->removed_flags;
+
+    cache->src = src;
+    cache->dst = dst;
+    cache->table_delete_total = world->info.table_delete_total;
+    cache->id_delete_total = world->info.id_delete_total;
+}
+
+/* Test if the commands for an entity match the cached batch. If so, apply the
+ * cached diff and update the commands like the regular batch code would. */
+static
+bool flecs_cmd_batch_cache_get(
+    ecs_world_t *world,
+    ecs_cmd_batch_cache_t *cache,
+    ecs_table_t *table,
+    ecs_table_diff_builder_t *diff,
+    ecs_cmd_t *cmds,
+    int32_t start,
+    bool *has_set)
+{
+    if (cache->src != table || 
+        cache->table_delete_total != world->info.table_delete_total ||
+        cache->id_delete_total != world->info.id_delete_total) 
+    {
+        return false;
+    }
+
+    ecs_cmd_batch_key_t *keys = ecs_vec_first(&cache->keys);
+    int32_t i = 0, count = ecs_vec_count(&cache->keys);
+    int32_t cur = start;
+    do {
+        ecs_cmd_t *cmd = &cmds[cur];
+        if (i == count || cmd->kind != keys[i].kind || cmd->id != keys[i].id) {
+            return false;
+        }
+        i ++;
+        cur = cmd->next_for_entity;
+        if (cur < 0) {
+            cur *= -1;
+        }
+    } while (cur);
+
+    if (i != count) {
+        return false;
+    }
+
+    cur = start;
+    do {
+        ecs_cmd_t *cmd = &cmds[cur];
+        switch(cmd->kind) {
+        case EcsCmdAddModified:
+            cmd->kind = EcsCmdModified;
+            world->info.cmd.batched_command_count ++;
+            break;
+        case EcsCmdAdd:
+            cmd->kind = EcsCmdSkip;
+            world->info.cmd.batched_command_count ++;
+            break;
+        case EcsCmdSet:
+        case EcsCmdEnsure:
+            *has_set = true;
+            world->info.cmd.batched_command_count ++;
+            break;
+        case EcsCmdModified:
+        case EcsCmdModifiedNoHook:
+        case EcsCmdRemove:
+        case EcsCmdClone:
+        case EcsCmdEmplace:
+        case EcsCmdBulkNew:
+        case EcsCmdPath:
+        case EcsCmdDelete:
+        case EcsCmdClear:
+        case EcsCmdOnDeleteAction:
+        case EcsCmdEnable:
+        case EcsCmdDisable:
+        case EcsCmdEvent:
+        case EcsCmdSkip:
+            break;
+        }
+        cur = cmd->next_for_entity;
+        if (cur < 0) {
+            cur *= -1;
+        }
+    } while (cur);
+
+    ecs_table_diff_t cached;
+    flecs_table_diff_build_noalloc(&cache->diff, &cached);
+    flecs_table_diff_build_append_table(world, diff, &cached);
+
+    return true;
+}
+
 static
 void flecs_cmd_batch_for_entity(
     ecs_world_t *world,
     ecs_table_diff_builder_t *diff,
+    ecs_cmd_batch_cache_t *cache,
     ecs_entity_t entity,
     ecs_cmd_t *cmds,
     int32_t start)
@@ -5921,6 +6172,17 @@ void flecs_cmd_batch_for_entity(
     int32_t cur = start;
     int32_t next_for_entity;
 
+    if (flecs_cmd_batch_cache_get(
+        world, cache, table, diff, cmds, start, &has_set)) 
+    {
+        table = cache->dst;
+        goto commit;
+    }
+
+    bool cacheable = true;
+    ecs_vec_clear(&cache->keys);
+    cache->src = NULL;
+
     do {
         ecs_cmd_t *cmd = &cmds[cur];
         ecs_id_t id = cmd->id;
@@ -5930,6 +6192,10 @@ void flecs_cmd_batch_for_entity(
             next_for_entity *= -1;
         }
 
+        if (cacheable) {
+            cacheable = flecs_cmd_batch_cache_push(world, cache, cmd);
+        }
+
         /* Check if added id is still valid (like is the parent of a ChildOf 
          * pair still alive), if not run cleanup actions for entity */
         if (id) {
@@ -5944,6 +6210,7 @@ void flecs_cmd_batch_for_entity(
                     
             if (cr && cr->flags & EcsIdDontFragment) {
                 /* Nothing to batch for non-fragmenting components */
+                cacheable = false;
                 continue;
             }
 
@@ -5951,6 +6218,7 @@ void flecs_cmd_batch_for_entity(
                 if (!id) {
                     /* Entity should remain alive but id should not be added */
                     cmd->kind = EcsCmdSkip;
+                    cacheable = false;
                     continue;
                 }
                 /* Entity should remain alive and id is still valid */
@@ -6038,6 +6306,11 @@ void flecs_cmd_batch_for_entity(
 
     ecs_assert(table != NULL, ECS_INTERNAL_ERROR, NULL);
 
+    if (cacheable) {
+        flecs_cmd_batch_cache_set(world, cache, start_table, table, diff);
+    }
+
+commit:
     /* Invoke OnAdd handlers after commit. This ensures that observers with 
      * mixed OnAdd/OnSet events won't get called with uninitialized values for
      * an OnSet field. */
@@ -6235,6 +6508,9 @@ bool flecs_defer_end(
             ecs_table_diff_builder_t diff;
             flecs_table_diff_builder_init(world, &diff);
 
+            ecs_cmd_batch_cache_t batch_cache;
+            flecs_cmd_batch_cache_init(world, &batch_cache);
+
             for (i = 0; i < count; i ++) {
                 ecs_cmd_t *cmd = &cmds[i];
                 ecs_entity_t e = cmd->entity;
@@ -6247,7 +6523,8 @@ bool flecs_defer_end(
 
                     /* Batch commands for entity to limit archetype moves */
                     if (is_alive) {
-                        flecs_cmd_batch_for_entity(world, &diff, e, cmds, i);
+                        flecs_cmd_batch_for_entity(
+                            world, &diff, &batch_cache, e, cmds, i);
                     } else {
                         world->info.cmd.discard_count ++;
                     }
@@ -6400,6 +6677,7 @@ bool flecs_defer_end(
             flecs_stack_reset(&commands->stack);
             ecs_vec_clear(queue);
             flecs_table_diff_builder_fini(world, &diff);
+            flecs_cmd_batch_cache_fini(world, &batch_cache);
 
             /* Internal callback for capturing commands, signal queue is done */
             if (world->on_commands_active) {
@@ -21068,6 +21346,8 @@ int ecs_fini(
     /* All queries are cleaned up, so monitors should've been cleaned up too */
     ecs_assert(!ecs_map_is_init(&world->monitors.monitors),
         ECS_INTERNAL_ERROR, NULL);
+    ecs_assert(!ecs_map_is_init(&world->query_index),
+        ECS_INTERNAL_ERROR, NULL);
 
     /* Cleanup world ctx and binding_ctx */
     if (world->ctx_free) {
@@ -21088,6 +21368,7 @@ int ecs_fini(
     flecs_name_index_fini(&world->aliases);
     flecs_name_index_fini(&world->symbols);
     ecs_set_stage_count(world, 0);
+    ecs_os_free(world->worker_cpus);
     ecs_vec_fini_t(&world->allocator, &world->component_ids, ecs_id_t);
     ecs_log_pop_1();
 
@@ -27403,6 +27684,7 @@ typedef struct ecs_pipeline_op_t {
     int32_t count;              /* Number of systems to run before next op */
     double time_spent;          /* Time spent merging commands for sync point */
     int64_t commands_enqueued;  /* Number of commands enqueued for sync point */
+    int32_t concurrent_count;   /* Number of concurrent systems at end of op */
     bool multi_threaded;        /* Whether systems can be ran multi threaded */
     bool immediate;           /* Whether systems are staged or not */
 } ecs_pipeline_op_t;
@@ -27411,11 +27693,13 @@ struct ecs_pipeline_state_t {
     ecs_query_t *query;         /* Pipeline query */
     ecs_vec_t ops;              /* Pipeline schedule */
     ecs_vec_t systems;          /* Vector with system ids */
+    ecs_vec_t claims;           /* Which systems a thread has claimed */
 
     ecs_entity_t last_system;   /* Last system ran by pipeline */
     ecs_component_record_t *cr_inactive; /* Cached record for quick inactive test */
     int32_t match_count;        /* Used to track of rebuild is necessary */
     int32_t rebuild_count;      /* Number of pipeline rebuilds */
+    bool threaded;              /* Was schedule built for worker threads */
     ecs_iter_t *iters;          /* Iterator for worker(s) */
     int32_t iter_count;
 
@@ -27424,6 +27708,7 @@ struct ecs_pipeline_state_t {
     int32_t cur_i;              /* Index in current result */
     int32_t ran_since_merge;    /* Index in current op */
     bool immediate;           /* Is pipeline in readonly mode */
+    bool concurrent;            /* Are concurrent systems of cur_op claimed */
 };
 
 typedef struct EcsPipeline {
@@ -27473,6 +27758,12 @@ void flecs_signal_workers(
 void flecs_wait_for_sync(
     ecs_world_t *world);
 
+void flecs_worker_barrier(
+    ecs_world_t *world,
+    ecs_stage_t *stage,
+    int32_t *counter,
+    int32_t count);
+
 #endif
 
 
@@ -29268,6 +29559,37 @@ ecs_entity_t flecs_run_system(
     ecs_ftime_t delta_time,
     void *param);
 
+/* The chunks of a work stealing system are numbered in query iteration order,
+ * and each stage owns a contiguous block of them. A stage claims chunks from
+ * its own block first and then from the blocks of the stages after it, by
+ * incrementing the block's counter.
+ * 
+ * Because a stage can end up running any chunk, it has to wait for the other
+ * stages before and after the system if other systems in the same pipeline
+ * operation access the same entities. */
+typedef struct ecs_system_steal_t {
+    int32_t stage_count;
+    int32_t chunk_rows;
+    int32_t chunk_count;
+    bool active;                     /* Set while the pipeline runs the system */
+    bool sync_before;                /* Wait for stages before running */
+    bool sync_after;                 /* Wait for stages after running */
+    int32_t arrived[2];              /* Barrier counters for before/after */
+    int32_t *claimed;                /* Chunks claimed per block, padded */
+} ecs_system_steal_t;
+
+/* Split the entities of a work stealing system into chunks before the worker
+ * threads run it. Must be called while the workers wait on a sync point.
+ * Returns whether the system will use work stealing. */
+bool flecs_system_steal_begin(
+    ecs_world_t *world,
+    ecs_system_t *system_data,
+    int32_t stage_count);
+
+/* Called after the worker threads ran the system */
+void flecs_system_steal_end(
+    ecs_system_t *system_data);
+
 #endif
 
 #endif
@@ -31206,15 +31528,25 @@ void* flecs_brealloc_w_dbg_info(
         return memory;
     }
 
-    result = flecs_balloc_w_dbg_info(dst, type_name);
-    if (result && src) {
-        ecs_size_t size = src->data_size;
-        if (dst->data_size < size) {
-            size = dst->data_size;
+    /* Allocations that are too large for a block come straight from the OS
+     * allocator. Let it resize those in place, which for large arrays such as
+     * table columns can be done by remapping pages instead of copying. */
+    if (dst && src && memory &&
+        dst->chunks_per_block <= FLECS_MIN_CHUNKS_PER_BLOCK &&
+        src->chunks_per_block <= FLECS_MIN_CHUNKS_PER_BLOCK)
+    {
+        result = ecs_os_realloc(memory, dst->data_size);
+    } else {
+        result = flecs_balloc_w_dbg_info(dst, type_name);
+        if (result && src) {
+            ecs_size_t size = src->data_size;
+            if (dst->data_size < size) {
+                size = dst->data_size;
+            }
+            ecs_os_memcpy(result, memory, size);
         }
-        ecs_os_memcpy(result, memory, size);
+        flecs_bfree_w_dbg_info(src, memory, type_name);
     }
-    flecs_bfree_w_dbg_info(src, memory, type_name);
 #endif
 #ifdef FLECS_MEMSET_UNINITIALIZED
     if (dst && src && (dst->data_size > src->data_size)) {
@@ -37095,7 +37427,7 @@ int flecs_query_finalize_terms(
                 if ((term->src.id & EcsTraverseFlags) == EcsSelf) {
                     if (!ecs_id_is_wildcard(term->id)) {
                         
-                        q->bloom_filter = flecs_table_bloom_filter_add(
+                        flecs_table_bloom_filter_add(
                             q->bloom_filter, term->id);
                     }
                 }
@@ -37369,8 +37701,7 @@ bool flecs_query_finalize_simple(
             trivial_count ++;            
 
             if ((term->src.id & EcsTraverseFlags) == EcsSelf) {
-                q->bloom_filter = flecs_table_bloom_filter_add(
-                    q->bloom_filter, id);
+                flecs_table_bloom_filter_add(q->bloom_filter, id);
             }
         }
     }
@@ -39999,8 +40330,7 @@ void flecs_table_init(
         }
 
         /* Build bloom filter for table */
-        table->bloom_filter = 
-            flecs_table_bloom_filter_add(table->bloom_filter, dst_id);
+        flecs_table_bloom_filter_add(table->bloom_filter, dst_id);
     }
 
     /* The easy part: initialize a record for every id in the type */
@@ -40157,7 +40487,7 @@ void flecs_table_init(
         tr->index = -1; /* The table doesn't have a (ChildOf, 0) component */
         tr->count = 0;
 
-        table->bloom_filter = flecs_table_bloom_filter_add(
+        flecs_table_bloom_filter_add(
             table->bloom_filter, ecs_pair(EcsChildOf, 0));
     }
 
@@ -40249,6 +40579,8 @@ void flecs_table_init(
         flecs_table_init_overrides(world, table, isa_tr);
     }
 
+    flecs_query_cache_match_new_table(world, table);
+
     if (table->flags & EcsTableHasOnTableCreate) {
         flecs_table_emit(world, table, EcsOnTableCreate);
     }
@@ -41619,6 +41951,96 @@ void flecs_table_swap(
     flecs_table_check_sanity(table);
 }
 
+/* Reorder rows of a table. Unlike flecs_table_swap, which is called once for
+ * each pair of rows, this visits each column once, which is faster when a large
+ * number of rows moves. Different tables can be permuted from multiple threads
+ * in parallel, which is why this doesn't use the world allocator and leaves
+ * marking the table dirty (which updates world state) to the caller. */
+void flecs_table_permute(
+    ecs_world_t *world,
+    ecs_table_t *table,
+    const int32_t *order)
+{
+    ecs_assert(!table->_->lock, ECS_LOCKED_STORAGE, 
+        FLECS_LOCKED_STORAGE_MSG("table permute"));
+    ecs_assert(order != NULL, ECS_INTERNAL_ERROR, NULL);
+
+    flecs_table_check_sanity(table);
+
+    int32_t i, count = ecs_table_count(table);
+    if (count < 2) {
+        return;
+    }
+
+    int32_t column_count = table->column_count;
+    ecs_column_t *columns = table->data.columns;
+    ecs_size_t tmp_size = ECS_SIZEOF(ecs_entity_t);
+    for (i = 0; i < column_count; i ++) {
+        tmp_size = ECS_MAX(tmp_size, columns[i].ti->size);
+    }
+
+    void *tmp = ecs_os_malloc(tmp_size * count);
+
+    /* Reorder entities & update records */
+    ecs_entity_t *entities = table->data.entities;
+    ecs_entity_t *tmp_entities = tmp;
+    ecs_os_memcpy_n(tmp_entities, entities, ecs_entity_t, count);
+    for (i = 0; i < count; i ++) {
+        ecs_entity_t e = entities[i] = tmp_entities[order[i]];
+        ecs_record_t *r = flecs_entities_get(world, e);
+        ecs_assert(r != NULL, ECS_INTERNAL_ERROR, NULL);
+        r->row = ECS_ROW_TO_RECORD(i, ECS_RECORD_TO_ROW_FLAGS(r->row));
+    }
+
+    /* Reorder bitsets */
+    int32_t bs_count = table->_->bs_count;
+    for (i = 0; i < bs_count; i ++) {
+        ecs_bitset_t *bs = &table->_->bs_columns[i];
+        ecs_bitset_t copy = *bs;
+        int32_t j, words = (count + 63) >> 6;
+        copy.data = tmp;
+        ecs_os_memcpy_n(copy.data, bs->data, uint64_t, words);
+        for (j = 0; j < count; j ++) {
+            flecs_bitset_set(bs, j, flecs_bitset_get(&copy, order[j]));
+        }
+    }
+
+    /* Reorder columns */
+    for (i = 0; i < column_count; i ++) {
+        ecs_column_t *column = &columns[i];
+        const ecs_type_info_t *ti = column->ti;
+        ecs_assert(ti != NULL, ECS_INTERNAL_ERROR, NULL);
+        ecs_size_t size = ti->size;
+        void *ptr = column->data;
+        int32_t j;
+
+        if (!ti->hooks.move) {
+            for (j = 0; j < count; j ++) {
+                ecs_os_memcpy(ECS_ELEM(tmp, size, j), 
+                    ECS_ELEM(ptr, size, order[j]), size);
+            }
+            ecs_os_memcpy(ptr, tmp, size * count);
+        } else {
+            ecs_move_t move_ctor = ti->hooks.move_ctor;
+            ecs_move_t move_dtor = ti->hooks.move_dtor;
+            ecs_assert(move_ctor != NULL, ECS_INTERNAL_ERROR, NULL);
+            ecs_assert(move_dtor != NULL, ECS_INTERNAL_ERROR, NULL);
+            for (j = 0; j < count; j ++) {
+                move_ctor(ECS_ELEM(tmp, size, j), 
+                    ECS_ELEM(ptr, size, order[j]), 1, ti);
+            }
+            for (j = 0; j < count; j ++) {
+                move_dtor(ECS_ELEM(ptr, size, j), 
+                    ECS_ELEM(tmp, size, j), 1, ti);
+            }
+        }
+    }
+
+    ecs_os_free(tmp);
+
+    flecs_table_check_sanity(table);
+}
+
 static
 void flecs_table_merge_vec(
     ecs_world_t *world,
@@ -41906,25 +42328,68 @@ ecs_id_t flecs_column_id(
     return table->type.array[type_index];
 }
 
+const ecs_table_record_t* flecs_table_get_record(
+    const ecs_world_t *world,
+    const ecs_table_t *table,
+    ecs_id_t id)
+{
+    int32_t index;
+
+    if (id < FLECS_HI_COMPONENT_ID) {
+        int16_t res = table->component_map[id];
+        if (!res) {
+            return NULL;
+        }
+        if (res > 0) {
+            index = table->column_map[table->type.count + (res - 1)];
+        } else {
+            index = -res - 1;
+        }
+    } else if (ecs_id_is_wildcard(id)) {
+        ecs_component_record_t *cr = flecs_components_get(world, id);
+        if (!cr) {
+            return NULL;
+        }
+        return flecs_component_get_table(cr, table);
+    } else {
+        index = flecs_type_index_of(&table->type, id);
+        if (index == -1) {
+            return NULL;
+        }
+    }
+
+    const ecs_table_record_t *tr = &table->_->records[index];
+    ecs_assert(tr->hdr.cr->id == id, ECS_INTERNAL_ERROR, NULL);
+    return tr;
+}
+
 int32_t flecs_table_observed_count(
     const ecs_table_t *table)
 {
     return table->_->traversable_count;
 }
 
-uint64_t flecs_table_bloom_filter_add(
-    uint64_t filter,
+/* Ids are mixed before picking a bit, as the low bits of a pair only contain
+ * the target, which would map all pairs with the same target to one bit. */
+void flecs_table_bloom_filter_add(
+    uint64_t *filter,
     uint64_t value)
 {
-    filter |= 1llu << (value % 64);
-    return filter;
+    uint64_t bit = ((value * 0x9E3779B97F4A7C15ull) >> 32) & 
+        (FLECS_BLOOM_FILTER_WORDS * 64 - 1);
+    filter[bit / 64] |= 1llu << (bit % 64);
 }
 
 bool flecs_table_bloom_filter_test(
     const ecs_table_t *table,
-    uint64_t filter)
+    const uint64_t *filter)
 {
-    return (table->bloom_filter & filter) == filter;
+    uint64_t missing = 0;
+    int32_t i;
+    for (i = 0; i < FLECS_BLOOM_FILTER_WORDS; i ++) {
+        missing |= filter[i] & ~table->bloom_filter[i];
+    }
+    return !missing;
 }
 
 
@@ -42586,6 +43051,107 @@ void flecs_table_hashmap_init(
         flecs_type_hash, flecs_type_compare, &world->allocator);
 }
 
+/* Exact id lookup in a sorted type. Large types are narrowed down with a
+ * binary search until a window of FLECS_TYPE_SCAN_WIDTH ids is left, which is
+ * then compared against the id four ids at a time. This is what query terms
+ * use to test tables for ids above FLECS_HI_COMPONENT_ID, so it replaces a hash
+ * lookup in the component record's table cache for each (term, table) pair. */
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FLECS_TYPE_SCAN_AVX2
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#define FLECS_TYPE_SCAN_SSE41
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FLECS_TYPE_SCAN_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FLECS_TYPE_SCAN_NEON
+#endif
+
+#define FLECS_TYPE_SCAN_WIDTH (16)
+
+/* Returns whether any of the 4 ids starting at array equals id */
+static
+bool flecs_type_scan4(
+    const ecs_id_t *array,
+    ecs_id_t id)
+{
+#if defined(FLECS_TYPE_SCAN_AVX2)
+    __m256i needle = _mm256_set1_epi64x((long long)id);
+    __m256i v = _mm256_loadu_si256((const __m256i*)array);
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi64(v, needle)) != 0;
+#elif defined(FLECS_TYPE_SCAN_SSE41)
+    __m128i needle = _mm_set1_epi64x((long long)id);
+    __m128i v0 = _mm_loadu_si128((const __m128i*)array);
+    __m128i v1 = _mm_loadu_si128((const __m128i*)&array[2]);
+    __m128i eq = _mm_or_si128(
+        _mm_cmpeq_epi64(v0, needle), _mm_cmpeq_epi64(v1, needle));
+    return _mm_movemask_epi8(eq) != 0;
+#elif defined(FLECS_TYPE_SCAN_SSE2)
+    /* No 64bit compare before SSE4.1, so compare 32bit halves and require both
+     * halves of a lane to match. */
+    __m128i needle = _mm_set1_epi64x((long long)id);
+    __m128i v0 = _mm_loadu_si128((const __m128i*)array);
+    __m128i v1 = _mm_loadu_si128((const __m128i*)&array[2]);
+    __m128i eq0 = _mm_cmpeq_epi32(v0, needle);
+    __m128i eq1 = _mm_cmpeq_epi32(v1, needle);
+    eq0 = _mm_and_si128(eq0, _mm_shuffle_epi32(eq0, _MM_SHUFFLE(2, 3, 0, 1)));
+    eq1 = _mm_and_si128(eq1, _mm_shuffle_epi32(eq1, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_movemask_epi8(_mm_or_si128(eq0, eq1)) != 0;
+#elif defined(FLECS_TYPE_SCAN_NEON)
+    uint64x2_t needle = vdupq_n_u64(id);
+    uint64x2_t eq = vorrq_u64(
+        vceqq_u64(vld1q_u64(array), needle),
+        vceqq_u64(vld1q_u64(&array[2]), needle));
+    return vmaxvq_u32(vreinterpretq_u32_u64(eq)) != 0;
+#else
+    return (array[0] == id) | (array[1] == id) | 
+        (array[2] == id) | (array[3] == id);
+#endif
+}
+
+int32_t flecs_type_index_of(
+    const ecs_type_t *type,
+    ecs_id_t id)
+{
+    const ecs_id_t *array = type->array;
+    int32_t lo = 0, count = type->count;
+
+    while (count > FLECS_TYPE_SCAN_WIDTH) {
+        int32_t half = count / 2;
+        if (array[lo + half] <= id) {
+            lo += half;
+            count -= half;
+        } else {
+            count = half;
+        }
+    }
+
+    const ecs_id_t *window = &array[lo];
+    int32_t i = 0;
+    for (; (i + 4) <= count; i += 4) {
+        if (window[i] > id) {
+            return -1;
+        }
+        if (flecs_type_scan4(&window[i], id)) {
+            break;
+        }
+    }
+
+    /* Resolve the position in the block that matched, or check the tail */
+    for (; i < count; i ++) {
+        if (window[i] == id) {
+            return lo + i;
+        }
+    }
+
+    return -1;
+}
+
 /* Find location where to insert id into type */
 static
 int flecs_type_find_insert(
@@ -57819,6 +58385,25 @@ ecs_os_thread_id_t win_thread_self(void)
     return (ecs_os_thread_id_t)GetCurrentThreadId();
 }
 
+static
+void win_thread_set_affinity(
+    const int32_t *cpus,
+    int32_t count)
+{
+    /* Only the CPUs of the thread's processor group can be addressed */
+    DWORD_PTR mask = 0;
+    int32_t i;
+    for (i = 0; i < count; i ++) {
+        if (cpus[i] >= 0 && cpus[i] < ECS_SIZEOF(DWORD_PTR) * 8) {
+            mask |= (DWORD_PTR)1 << cpus[i];
+        }
+    }
+
+    if (!mask || !SetThreadAffinityMask(GetCurrentThread(), mask)) {
+        ecs_warn("failed to set thread affinity");
+    }
+}
+
 static
 int32_t win_ainc(
     int32_t *count) 
@@ -58026,6 +58611,7 @@ void ecs_set_os_api_impl(void) {
     api.thread_new_ = win_thread_new;
     api.thread_join_ = win_thread_join;
     api.thread_self_ = win_thread_self;
+    api.thread_set_affinity_ = win_thread_set_affinity;
     api.task_new_ = win_thread_new;
     api.task_join_ = win_thread_join;
     api.ainc_ = win_ainc;
@@ -58061,6 +58647,13 @@ void ecs_set_os_api_impl(void) {
  */
 
 #include "pthread.h"
+#include <sched.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 #if defined(__APPLE__) && defined(__MACH__)
 #include <mach/mach_time.h>
@@ -58108,6 +58701,261 @@ ecs_os_thread_id_t posix_thread_self(void)
     return (ecs_os_thread_id_t)pthread_self();
 }
 
+#ifdef __GNUC__
+
+/* Task pool. Threads that run tasks are kept after the task is done, so that
+ * worlds using ecs_set_task_threads don't create and join a thread for each
+ * worker every frame, and changing the number of task threads doesn't either.
+ * 
+ * Tasks are passed to the pool threads through a bounded lock free MPMC queue.
+ * Tasks started by the same world wait for each other, so each queued task is
+ * guaranteed a thread: when no pool thread is idle a new one is created. The
+ * pool only grows, up to the largest number of tasks that ran at once, and is
+ * joined by the OS API fini callback. */
+#define POSIX_TASK_QUEUE_SIZE (256)
+
+typedef struct posix_task_t {
+    ecs_os_thread_callback_t callback;
+    void *arg;
+    void *result;
+    int32_t done;
+} posix_task_t;
+
+typedef struct posix_task_slot_t {
+    uint32_t seq;
+    posix_task_t *task;
+} posix_task_slot_t;
+
+static struct {
+    posix_task_slot_t slots[POSIX_TASK_QUEUE_SIZE];
+    uint32_t head;
+    uint32_t tail;
+    int32_t idle;                   /* Threads not reserved for a task */
+    int32_t sleepers;               /* Threads blocked on cond */
+    bool quit;
+    pthread_mutex_t lock;           /* Protects threads, used to block */
+    pthread_cond_t cond;
+    pthread_t *threads;
+    int32_t thread_count;
+} posix_task_pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER
+};
+
+static pthread_once_t posix_task_pool_once = PTHREAD_ONCE_INIT;
+
+static
+void posix_task_pool_init(void) {
+    uint32_t i;
+    for (i = 0; i < POSIX_TASK_QUEUE_SIZE; i ++) {
+        posix_task_pool.slots[i].seq = i;
+    }
+}
+
+static
+bool posix_task_push(
+    posix_task_t *task)
+{
+    uint32_t pos = __atomic_load_n(&posix_task_pool.tail, __ATOMIC_RELAXED);
+    posix_task_slot_t *slot;
+
+    for (;;) {
+        slot = &posix_task_pool.slots[pos % POSIX_TASK_QUEUE_SIZE];
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - pos);
+        if (!diff) {
+            if (__atomic_compare_exchange_n(&posix_task_pool.tail, &pos, 
+                pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) 
+            {
+                break;
+            }
+        } else if (diff < 0) {
+            return false; /* Full */
+        } else {
+            pos = __atomic_load_n(&posix_task_pool.tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->task = task;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static
+posix_task_t* posix_task_pop(void) {
+    uint32_t pos = __atomic_load_n(&posix_task_pool.head, __ATOMIC_RELAXED);
+    posix_task_slot_t *slot;
+
+    for (;;) {
+        slot = &posix_task_pool.slots[pos % POSIX_TASK_QUEUE_SIZE];
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - (pos + 1));
+        if (!diff) {
+            if (__atomic_compare_exchange_n(&posix_task_pool.head, &pos, 
+                pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) 
+            {
+                break;
+            }
+        } else if (diff < 0) {
+            return NULL; /* Empty */
+        } else {
+            pos = __atomic_load_n(&posix_task_pool.head, __ATOMIC_RELAXED);
+        }
+    }
+
+    posix_task_t *task = slot->task;
+    __atomic_store_n(&slot->seq, pos + POSIX_TASK_QUEUE_SIZE, __ATOMIC_RELEASE);
+    return task;
+}
+
+/* Wake threads blocked in posix_task_block, after changing what they wait 
+ * for. The sleeper count is only nonzero while a thread is about to block or
+ * blocked, so the common case doesn't touch the mutex. */
+static
+void posix_task_wake(void) {
+    if (!__atomic_load_n(&posix_task_pool.sleepers, __ATOMIC_SEQ_CST)) {
+        return;
+    }
+
+    pthread_mutex_lock(&posix_task_pool.lock);
+    pthread_cond_broadcast(&posix_task_pool.cond);
+    pthread_mutex_unlock(&posix_task_pool.lock);
+}
+
+/* Block until ready returns true for ctx */
+static
+void posix_task_block(
+    bool (*ready)(void *ctx),
+    void *ctx)
+{
+    while (!ready(ctx)) {
+        __atomic_add_fetch(&posix_task_pool.sleepers, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_lock(&posix_task_pool.lock);
+        if (!ready(ctx)) {
+            pthread_cond_wait(&posix_task_pool.cond, &posix_task_pool.lock);
+        }
+        pthread_mutex_unlock(&posix_task_pool.lock);
+        __atomic_sub_fetch(&posix_task_pool.sleepers, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+static
+bool posix_task_pool_ready(
+    void *ctx)
+{
+    (void)ctx;
+    return __atomic_load_n(&posix_task_pool.quit, __ATOMIC_SEQ_CST) ||
+        __atomic_load_n(&posix_task_pool.head, __ATOMIC_SEQ_CST) !=
+        __atomic_load_n(&posix_task_pool.tail, __ATOMIC_SEQ_CST);
+}
+
+static
+bool posix_task_done(
+    void *ctx)
+{
+    posix_task_t *task = ctx;
+    return __atomic_load_n(&task->done, __ATOMIC_SEQ_CST) != 0;
+}
+
+static
+void* posix_task_thread(
+    void *arg)
+{
+    (void)arg;
+
+    for (;;) {
+        posix_task_t *task = posix_task_pop();
+        if (task) {
+            task->result = task->callback(task->arg);
+            __atomic_store_n(&task->done, 1, __ATOMIC_SEQ_CST);
+            __atomic_add_fetch(&posix_task_pool.idle, 1, __ATOMIC_SEQ_CST);
+            posix_task_wake();
+        } else if (__atomic_load_n(&posix_task_pool.quit, __ATOMIC_SEQ_CST)) {
+            break;
+        } else {
+            posix_task_block(posix_task_pool_ready, NULL);
+        }
+    }
+
+    return NULL;
+}
+
+static
+ecs_os_thread_t posix_task_new(
+    ecs_os_thread_callback_t callback, 
+    void *arg)
+{
+    pthread_once(&posix_task_pool_once, posix_task_pool_init);
+
+    posix_task_t *task = ecs_os_calloc_t(posix_task_t);
+    task->callback = callback;
+    task->arg = arg;
+
+    while (!posix_task_push(task)) {
+        sched_yield(); /* Queue is full, wait for pool threads to drain it */
+    }
+
+    /* Reserve an idle thread for the task, or add one */
+    if (__atomic_sub_fetch(&posix_task_pool.idle, 1, __ATOMIC_SEQ_CST) < 0) {
+        __atomic_add_fetch(&posix_task_pool.idle, 1, __ATOMIC_SEQ_CST);
+
+        pthread_mutex_lock(&posix_task_pool.lock);
+        posix_task_pool.threads = ecs_os_realloc_n(posix_task_pool.threads, 
+            pthread_t, posix_task_pool.thread_count + 1);
+        if (pthread_create(&posix_task_pool.threads[
+            posix_task_pool.thread_count], NULL, posix_task_thread, NULL)) 
+        {
+            ecs_os_abort();
+        }
+        posix_task_pool.thread_count ++;
+        pthread_mutex_unlock(&posix_task_pool.lock);
+    } else {
+        posix_task_wake();
+    }
+
+    return (ecs_os_thread_t)(uintptr_t)task;
+}
+
+static
+void* posix_task_join(
+    ecs_os_thread_t thread)
+{
+    posix_task_t *task = (posix_task_t*)(uintptr_t)thread;
+    posix_task_block(posix_task_done, task);
+
+    void *result = task->result;
+    ecs_os_free(task);
+    return result;
+}
+
+static
+void posix_task_pool_fini(void) {
+    pthread_mutex_lock(&posix_task_pool.lock);
+    pthread_t *threads = posix_task_pool.threads;
+    int32_t i, count = posix_task_pool.thread_count;
+    posix_task_pool.threads = NULL;
+    posix_task_pool.thread_count = 0;
+    pthread_mutex_unlock(&posix_task_pool.lock);
+
+    if (!count) {
+        return;
+    }
+
+    __atomic_store_n(&posix_task_pool.quit, true, __ATOMIC_SEQ_CST);
+    posix_task_wake();
+
+    for (i = 0; i < count; i ++) {
+        pthread_join(threads[i], NULL);
+    }
+    ecs_os_free(threads);
+
+    /* Threads that exited were idle, the pool can be used again */
+    __atomic_store_n(&posix_task_pool.idle, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&posix_task_pool.quit, false, __ATOMIC_SEQ_CST);
+}
+
+#endif
+
 static
 int32_t posix_ainc(
     int32_t *count)
@@ -58355,6 +59203,49 @@ uint64_t posix_time_now(void) {
     return now;
 }
 
+static
+void posix_fini(void) {
+#ifdef __GNUC__
+    posix_task_pool_fini();
+#endif
+}
+
+#if defined(__linux__)
+static
+void posix_thread_set_affinity(
+    const int32_t *cpus,
+    int32_t count)
+{
+    /* Same size as cpu_set_t, which needs _GNU_SOURCE */
+    unsigned long mask[1024 / (8 * sizeof(unsigned long))] = {0};
+    int32_t i, bits = ECS_SIZEOF(unsigned long) * 8;
+    for (i = 0; i < count; i ++) {
+        if (cpus[i] >= 0 && cpus[i] < 1024) {
+            mask[cpus[i] / bits] |= 1ul << (cpus[i] % bits);
+        }
+    }
+
+    if (syscall(SYS_sched_setaffinity, 0, sizeof(mask), mask)) {
+        ecs_warn("failed to set thread affinity");
+    }
+}
+
+static
+void posix_futex_wait(
+    int32_t *value,
+    int32_t expected)
+{
+    syscall(SYS_futex, value, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static
+void posix_futex_wake(
+    int32_t *value)
+{
+    syscall(SYS_futex, value, FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL, 0);
+}
+#endif
+
 void ecs_set_os_api_impl(void) {
     ecs_os_set_api_defaults();
 
@@ -58363,8 +59254,16 @@ void ecs_set_os_api_impl(void) {
     api.thread_new_ = posix_thread_new;
     api.thread_join_ = posix_thread_join;
     api.thread_self_ = posix_thread_self;
+#if defined(__linux__)
+    api.thread_set_affinity_ = posix_thread_set_affinity;
+#endif
+#ifdef __GNUC__
+    api.task_new_ = posix_task_new;
+    api.task_join_ = posix_task_join;
+#else
     api.task_new_ = posix_thread_new;
     api.task_join_ = posix_thread_join;
+#endif
     api.ainc_ = posix_ainc;
     api.adec_ = posix_adec;
     api.lainc_ = posix_lainc;
@@ -58378,8 +59277,13 @@ void ecs_set_os_api_impl(void) {
     api.cond_signal_ = posix_cond_signal;
     api.cond_broadcast_ = posix_cond_broadcast;
     api.cond_wait_ = posix_cond_wait;
+#if defined(__linux__)
+    api.futex_wait_ = posix_futex_wait;
+    api.futex_wake_ = posix_futex_wake;
+#endif
     api.sleep_ = posix_sleep;
     api.now_ = posix_time_now;
+    api.fini_ = posix_fini;
 
     posix_time_setup();
 
@@ -59225,6 +60129,7 @@ static void flecs_pipeline_free(
         ecs_allocator_t *a = &world->allocator;
         ecs_vec_fini_t(a, &p->ops, ecs_pipeline_op_t);
         ecs_vec_fini_t(a, &p->systems, ecs_system_t*);
+        ecs_vec_fini_t(a, &p->claims, int32_t);
         ecs_os_free(p->iters);
         ecs_query_fini(p->query);
         ecs_os_free(p);
@@ -59459,6 +60364,143 @@ EcsPoly* flecs_pipeline_term_system(
     return poly;
 }
 
+/* Returns how a system that runs concurrently accesses the data of a term:
+ * 0 if it doesn't, 1 if it reads and 2 if it writes. */
+static
+int32_t flecs_pipeline_term_access(
+    const ecs_term_t *term)
+{
+    int16_t inout = term->inout;
+    if (inout == EcsInOutFilter || inout == EcsInOutNone || 
+        term->oper == EcsNot) 
+    {
+        return 0;
+    }
+
+    if (inout == EcsInOutDefault) {
+        if (ecs_term_match_0(term)) {
+            /* Same as for merges, this is just an id passed to the system */
+            return 0;
+        } else if (!ecs_term_match_this(term) || 
+            !(term->src.id & EcsSelf)) 
+        {
+            inout = EcsIn;
+        } else {
+            inout = EcsInOut;
+        }
+    }
+
+    return inout == EcsIn ? 1 : 2;
+}
+
+static
+bool flecs_pipeline_ids_overlap(
+    ecs_id_t a,
+    ecs_id_t b)
+{
+    if (a == EcsWildcard || a == EcsAny || b == EcsWildcard || b == EcsAny) {
+        return true;
+    }
+    return ecs_id_match(a, b) || ecs_id_match(b, a);
+}
+
+/* Returns whether two systems of an op must not run at the same time. Systems
+ * that aren't concurrent conflict with every other system. */
+static
+bool flecs_pipeline_systems_conflict(
+    const ecs_system_t *a,
+    const ecs_system_t *b)
+{
+    if (!a->concurrent || !b->concurrent) {
+        return true;
+    }
+
+    const ecs_query_t *qa = a->query, *qb = b->query;
+    int32_t ta, tb;
+    for (ta = 0; ta < qa->term_count; ta ++) {
+        int32_t access_a = flecs_pipeline_term_access(&qa->terms[ta]);
+        if (!access_a) {
+            continue;
+        }
+
+        for (tb = 0; tb < qb->term_count; tb ++) {
+            int32_t access_b = flecs_pipeline_term_access(&qb->terms[tb]);
+            if (!access_b || (access_a == 1 && access_b == 1)) {
+                continue;
+            }
+
+            if (flecs_pipeline_ids_overlap(
+                qa->terms[ta].id, qb->terms[tb].id)) 
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/* Returns whether a system conflicts with a concurrent system that comes
+ * earlier in the same op. Concurrent systems run after the other systems of
+ * their op, and may enqueue their commands on any stage, so the commands of 
+ * both systems could get merged out of pipeline order. Systems that are not
+ * concurrent conflict with every concurrent system. */
+static
+bool flecs_pipeline_check_concurrent(
+    const ecs_pipeline_state_t *pq,
+    const ecs_pipeline_op_t *op,
+    const ecs_system_t *sys)
+{
+    ecs_system_t **systems = ecs_vec_first_t(&pq->systems, ecs_system_t*);
+    int32_t i, end = op->offset + op->count;
+    for (i = op->offset; i < end; i ++) {
+        if (systems[i]->concurrent && 
+            flecs_pipeline_systems_conflict(systems[i], sys)) 
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Count the concurrent systems of staged, single threaded ops. Because the 
+ * build inserts a merge before a system that conflicts with an earlier 
+ * concurrent system, they are at the end of the op and don't conflict with
+ * each other. An op only runs them on the worker threads if there are at 
+ * least two, otherwise the whole op keeps running on the main thread. */
+static
+void flecs_pipeline_build_concurrent(
+    ecs_world_t *world,
+    ecs_pipeline_state_t *pq)
+{
+    ecs_allocator_t *a = &world->allocator;
+    ecs_vec_set_count_t(a, &pq->claims, int32_t, ecs_vec_count(&pq->systems));
+
+    ecs_system_t **systems = ecs_vec_first_t(&pq->systems, ecs_system_t*);
+    int32_t o, op_count = ecs_vec_count(&pq->ops);
+    ecs_pipeline_op_t *ops = ecs_vec_first_t(&pq->ops, ecs_pipeline_op_t);
+
+    for (o = 0; o < op_count; o ++) {
+        ecs_pipeline_op_t *op = &ops[o];
+        int32_t i = op->offset + op->count;
+
+        op->concurrent_count = 0;
+        if (!pq->threaded || op->multi_threaded || op->immediate) {
+            continue;
+        }
+
+        while (i > op->offset && systems[i - 1]->concurrent) {
+            op->concurrent_count ++;
+            i --;
+        }
+
+        if (op->concurrent_count < 2) {
+            op->concurrent_count = 0;
+        }
+    }
+}
+
 static
 bool flecs_pipeline_build(
     ecs_world_t *world,
@@ -59467,7 +60509,8 @@ bool flecs_pipeline_build(
     ecs_iter_t it = ecs_query_iter(world, pq->query);
 
     int32_t new_match_count = ecs_query_match_count(pq->query);
-    if (pq->match_count == new_match_count) {
+    bool threaded = world->worker_cond != 0;
+    if (pq->match_count == new_match_count && pq->threaded == threaded) {
         /* No need to rebuild the pipeline */
         ecs_iter_fini(&it);
         return false;
@@ -59475,6 +60518,7 @@ bool flecs_pipeline_build(
 
     world->info.pipeline_build_count_total ++;
     pq->rebuild_count ++;
+    pq->threaded = threaded;
 
     ecs_allocator_t *a = &world->allocator;
     ecs_pipeline_op_t *op = NULL;
@@ -59526,6 +60570,16 @@ bool flecs_pipeline_build(
                 needs_merge = true;
             }
 
+            /* Keep commands of conflicting concurrent systems in order. 
+             * Without worker threads all systems run in pipeline order on
+             * the main thread, so no merge is needed. */
+            if (threaded && is_active && !needs_merge && !multi_threaded && 
+                op && op->count && 
+                flecs_pipeline_check_concurrent(pq, op, sys)) 
+            {
+                needs_merge = true;
+            }
+
             if (needs_merge) {
                 /* After merge all components will be merged, so reset state */
                 flecs_pipeline_reset_write_state(&ws);
@@ -59557,6 +60611,7 @@ bool flecs_pipeline_build(
                 op = ecs_vec_append_t(a, &pq->ops, ecs_pipeline_op_t);
                 op->offset = ecs_vec_count(&pq->systems);
                 op->count = 0;
+                op->concurrent_count = 0;
                 op->multi_threaded = false;
                 op->immediate = false;
                 op->time_spent = 0;
@@ -59583,6 +60638,8 @@ bool flecs_pipeline_build(
     ecs_map_fini(&ws.ids);
     ecs_map_fini(&ws.wildcard_ids);
 
+    flecs_pipeline_build_concurrent(world, pq);
+
     op = ecs_vec_first_t(&pq->ops, ecs_pipeline_op_t);
 
     if (!op) {
@@ -59593,8 +60650,9 @@ bool flecs_pipeline_build(
         ecs_dbg("#[bold]pipeline rebuild");
         ecs_log_push_1();
 
-        ecs_dbg("#[green]schedule#[reset]: threading: %d, staging: %d:", 
-            op->multi_threaded, !op->immediate);
+        ecs_dbg("#[green]schedule#[reset]: threading: %d, staging: %d, "
+            "concurrent: %d:", op->multi_threaded, !op->immediate, 
+            op->concurrent_count);
         ecs_log_push_1();
 
         int32_t i, count = ecs_vec_count(&pq->systems);
@@ -59636,9 +60694,10 @@ bool flecs_pipeline_build(
                 if (op_index < ecs_vec_count(&pq->ops)) {
                     ecs_dbg(
                         "#[green]schedule#[reset]: "
-                        "threading: %d, staging: %d:",
+                        "threading: %d, staging: %d, concurrent: %d:",
                         op[op_index].multi_threaded, 
-                        !op[op_index].immediate);
+                        !op[op_index].immediate,
+                        op[op_index].concurrent_count);
                 }
                 ecs_log_push_1();
             }
@@ -59743,6 +60802,107 @@ void ecs_run_pipeline(
     }
 }
 
+/* Prepare or finish work stealing for the systems of the current op. Stages
+ * only need to wait for each other around a work stealing system when it's
+ * not the first or last system in the op, and two work stealing systems in a
+ * row share a single barrier. */
+static
+void flecs_pipeline_steal(
+    ecs_world_t *world,
+    ecs_pipeline_state_t *pq,
+    int32_t stage_count,
+    bool begin)
+{
+    ecs_pipeline_op_t *op = pq->cur_op;
+    ecs_system_t **systems = ecs_vec_first_t(&pq->systems, ecs_system_t*);
+    int32_t i, end = ECS_MIN(op->offset + op->count, 
+        ecs_vec_count(&pq->systems));
+    bool prev_synced = true;
+
+    for (i = pq->cur_i; i < end; i ++) {
+        ecs_system_t *sys = systems[i];
+        if (!begin) {
+            flecs_system_steal_end(sys);
+        } else if (flecs_system_steal_begin(world, sys, stage_count)) {
+            sys->steal->sync_before = !prev_synced;
+            sys->steal->sync_after = i != (end - 1);
+            prev_synced = true;
+        } else {
+            prev_synced = false;
+        }
+    }
+}
+
+/* Can the systems of the current op run concurrently. Only when the op is 
+ * started from its first system, not when resuming after a rebuild. */
+static
+bool flecs_pipeline_op_concurrent(
+    ecs_pipeline_state_t *pq)
+{
+    return pq->cur_op->concurrent_count && pq->cur_i == pq->cur_op->offset;
+}
+
+/* Run the systems of the current op that aren't concurrent. This happens on
+ * the main thread before the workers are signaled, so the systems have the
+ * world to themselves, same as in an op without concurrent systems. */
+static
+void flecs_run_pipeline_serial(
+    ecs_world_t* world,
+    ecs_stage_t* stage,
+    int32_t stage_count,
+    ecs_ftime_t delta_time)
+{
+    ecs_pipeline_state_t* pq = world->pq;
+    ecs_pipeline_op_t* op = pq->cur_op;
+    ecs_system_t **systems = ecs_vec_first_t(&pq->systems, ecs_system_t*);
+    int32_t i, end = op->offset + op->count - op->concurrent_count;
+
+    ecs_os_memset_n(ecs_vec_get_t(&pq->claims, int32_t, end), 0, 
+        int32_t, op->concurrent_count);
+
+    for (i = op->offset; i < end; i ++) {
+        ecs_system_t *sys = systems[i];
+        sys->last_frame = world->info.frame_count_total + 1;
+        flecs_run_system(world, stage, sys->query->entity, sys, 0, 
+            stage_count, delta_time, NULL);
+        ecs_os_linc(&world->info.systems_ran_frame);
+    }
+}
+
+/* Run the concurrent systems of the current op. Each system is claimed by 
+ * whichever thread gets to it first. */
+static
+int32_t flecs_run_pipeline_concurrent(
+    ecs_world_t* world,
+    ecs_stage_t* stage,
+    int32_t stage_index,
+    int32_t stage_count,
+    ecs_ftime_t delta_time)
+{
+    ecs_pipeline_state_t* pq = world->pq;
+    ecs_pipeline_op_t* op = pq->cur_op;
+    ecs_system_t **systems = ecs_vec_first_t(&pq->systems, ecs_system_t*);
+    int32_t *claims = ecs_vec_first_t(&pq->claims, int32_t);
+    int32_t i, end = op->offset + op->count;
+
+    for (i = end - op->concurrent_count; i < end; i ++) {
+        ecs_system_t *sys = systems[i];
+        if (stage_index == 0) {
+            sys->last_frame = world->info.frame_count_total + 1;
+        }
+
+        if (ecs_os_ainc(&claims[i]) != 1) {
+            continue;
+        }
+
+        flecs_run_system(world, stage, sys->query->entity, sys, 
+            stage_index, stage_count, delta_time, NULL);
+        ecs_os_linc(&world->info.systems_ran_frame);
+    }
+
+    return end - 1;
+}
+
 int32_t flecs_run_pipeline_ops(
     ecs_world_t* world,
     ecs_stage_t* stage,
@@ -59754,7 +60914,13 @@ int32_t flecs_run_pipeline_ops(
     ecs_pipeline_op_t* op = pq->cur_op;
     int32_t i = pq->cur_i;
 
-    ecs_assert(!stage_index || op->multi_threaded, ECS_INTERNAL_ERROR, NULL);
+    ecs_assert(!stage_index || op->multi_threaded || pq->concurrent, 
+        ECS_INTERNAL_ERROR, NULL);
+
+    if (pq->concurrent) {
+        return flecs_run_pipeline_concurrent(
+            world, stage, stage_index, stage_count, delta_time);
+    }
 
     int32_t count = ecs_vec_count(&pq->systems);
     ecs_system_t **systems = ecs_vec_first_t(&pq->systems, ecs_system_t*);
@@ -59777,9 +60943,18 @@ int32_t flecs_run_pipeline_ops(
             s = stage;
         }
 
+        ecs_system_steal_t *steal = sys->steal;
+        if (steal && steal->active && steal->sync_before) {
+            flecs_worker_barrier(world, stage, &steal->arrived[0], stage_count);
+        }
+
         flecs_run_system(world, s, sys->query->entity, sys, stage_index,
             stage_count, delta_time, NULL);
 
+        if (steal && steal->active && steal->sync_after) {
+            flecs_worker_barrier(world, stage, &steal->arrived[1], stage_count);
+        }
+
         ecs_os_linc(&world->info.systems_ran_frame);
         ran_since_merge++;
 
@@ -59825,29 +61000,41 @@ void flecs_run_pipeline(
         }
 
         bool immediate = pq->cur_op->immediate;
-        bool op_multi_threaded = multi_threaded && pq->cur_op->multi_threaded;
+        bool op_concurrent = multi_threaded && flecs_pipeline_op_concurrent(pq);
+        bool op_multi_threaded = op_concurrent || 
+            (multi_threaded && pq->cur_op->multi_threaded);
 
         pq->immediate = immediate;
 
+        /* Workers use this to pick how to run the op, so it must be set 
+         * before they're signaled and not change while they run. */
+        pq->concurrent = op_concurrent;
+
         if (!immediate) {
             ecs_readonly_begin(world, multi_threaded);
         } else {
             flecs_defer_begin(world, stage);
         }
 
+        ecs_time_t st = { 0 };
+        bool measure_time = world->flags & EcsWorldMeasureSystemTime;
+        if (measure_time) {
+            ecs_time_measure(&st);
+        }
+
+        if (op_concurrent) {
+            ECS_BIT_CLEAR(world->flags, EcsWorldMultiThreaded);
+            flecs_run_pipeline_serial(world, stage, stage_count, delta_time);
+        }
+
         ECS_BIT_COND(world->flags, EcsWorldMultiThreaded, op_multi_threaded);
         ecs_assert(world->workers_waiting == 0, ECS_INTERNAL_ERROR, NULL);
 
         if (op_multi_threaded) {
+            flecs_pipeline_steal(world, pq, stage_count, true);
             flecs_signal_workers(world);
         }
 
-        ecs_time_t st = { 0 };
-        bool measure_time = world->flags & EcsWorldMeasureSystemTime;
-        if (measure_time) {
-            ecs_time_measure(&st);
-        }
-
         const int32_t i = flecs_run_pipeline_ops(
             world, stage, stage_index, stage_count, delta_time);
 
@@ -59858,6 +61045,7 @@ void flecs_run_pipeline(
 
         if (op_multi_threaded) {
             flecs_wait_for_sync(world);
+            flecs_pipeline_steal(world, pq, stage_count, false);
         }
 
         if (!immediate) {
@@ -60163,28 +61351,218 @@ void FlecsPipelineImport(
 
 #ifdef FLECS_PIPELINE
 
+/* Number of times a thread polls a sync counter before it parks, when using
+ * EcsWorkerSyncAtomic. Each stage adapts its budget between the min and max:
+ * spinning only pays off when the other threads are actually running, which
+ * isn't the case when there are more threads than cores. */
+#define FLECS_WORKER_SPIN_MIN (16)
+#define FLECS_WORKER_SPIN_MAX (4096)
+
+static
+int32_t flecs_worker_load(
+    int32_t *value)
+{
+#ifdef __GNUC__
+    return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+#else
+    return *(volatile int32_t*)value;
+#endif
+}
+
+static
+void flecs_worker_pause(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_ia32_pause();
+#elif defined(__GNUC__) && defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/* Block while *value equals expected. May return spuriously. */
+static
+void flecs_worker_park(
+    ecs_world_t *world,
+    int32_t *value,
+    int32_t expected)
+{
+    /* Must be visible before *value is checked again, so that a thread that
+     * changes *value and then finds no sleepers can't miss this one. */
+    ecs_os_ainc(&world->sync_sleepers);
+
+    if (ecs_os_api.futex_wait_) {
+        ecs_os_futex_wait(value, expected);
+    } else {
+        ecs_os_mutex_lock(world->sync_mutex);
+        if (flecs_worker_load(value) == expected) {
+            ecs_os_cond_wait(world->park_cond, world->sync_mutex);
+        }
+        ecs_os_mutex_unlock(world->sync_mutex);
+    }
+
+    ecs_os_adec(&world->sync_sleepers);
+}
+
+/* Wake threads parked on value, after value was changed atomically */
+static
+void flecs_worker_wake(
+    ecs_world_t *world,
+    int32_t *value)
+{
+    if (!flecs_worker_load(&world->sync_sleepers)) {
+        return;
+    }
+
+    if (ecs_os_api.futex_wake_) {
+        ecs_os_futex_wake(value);
+    } else {
+        ecs_os_mutex_lock(world->sync_mutex);
+        ecs_os_cond_broadcast(world->park_cond);
+        ecs_os_mutex_unlock(world->sync_mutex);
+    }
+}
+
+static
+int32_t flecs_worker_spin_budget(
+    ecs_stage_t *stage)
+{
+    if (!stage->sync_spin) {
+        stage->sync_spin = FLECS_WORKER_SPIN_MAX / 4;
+    }
+    return stage->sync_spin;
+}
+
+/* Grow the budget when spinning succeeded, shrink it when the thread parked */
+static
+void flecs_worker_spin_adapt(
+    ecs_stage_t *stage,
+    bool parked)
+{
+    if (parked) {
+        stage->sync_spin = ECS_MAX(FLECS_WORKER_SPIN_MIN, stage->sync_spin / 2);
+    } else {
+        stage->sync_spin = ECS_MIN(FLECS_WORKER_SPIN_MAX, stage->sync_spin * 2);
+    }
+}
+
+/* Wait until the main thread increases the sync epoch */
+static
+void flecs_worker_wait_for_epoch(
+    ecs_world_t *world,
+    ecs_stage_t *stage,
+    int32_t epoch)
+{
+    int32_t i, spin = flecs_worker_spin_budget(stage);
+    for (i = 0; i < spin; i ++) {
+        if (flecs_worker_load(&world->sync_epoch) != epoch) {
+            flecs_worker_spin_adapt(stage, false);
+            return;
+        }
+        flecs_worker_pause();
+    }
+
+    while (flecs_worker_load(&world->sync_epoch) == epoch) {
+        flecs_worker_park(world, &world->sync_epoch, epoch);
+    }
+    flecs_worker_spin_adapt(stage, true);
+}
+
+/* Wait until a counter reaches the number of workers */
+static
+void flecs_worker_wait_for_count(
+    ecs_world_t *world,
+    ecs_stage_t *stage,
+    int32_t *counter,
+    int32_t count)
+{
+    int32_t i, value, spin = flecs_worker_spin_budget(stage);
+    for (i = 0; i < spin; i ++) {
+        if (flecs_worker_load(counter) == count) {
+            flecs_worker_spin_adapt(stage, false);
+            return;
+        }
+        flecs_worker_pause();
+    }
+
+    while ((value = flecs_worker_load(counter)) != count) {
+        flecs_worker_park(world, counter, value);
+    }
+    flecs_worker_spin_adapt(stage, true);
+}
+
+/* Wait until count threads reached the barrier. The counter must be reset
+ * before the workers are signaled. */
+void flecs_worker_barrier(
+    ecs_world_t *world,
+    ecs_stage_t *stage,
+    int32_t *counter,
+    int32_t count)
+{
+    if (ecs_os_ainc(counter) == count) {
+        flecs_worker_wake(world, counter);
+        return;
+    }
+
+    flecs_worker_wait_for_count(world, stage, counter, count);
+}
+
 /* Synchronize workers */
 static
 void flecs_sync_worker(
-    ecs_world_t* world)
+    ecs_world_t* world,
+    ecs_stage_t *stage)
 {
     int32_t stage_count = ecs_get_stage_count(world);
     if (stage_count <= 1) {
         return;
     }
 
+    if (world->worker_sync == EcsWorkerSyncAtomic) {
+        /* Read the epoch first, the main thread may release workers as soon
+         * as the last one is counted. */
+        int32_t epoch = flecs_worker_load(&world->sync_epoch);
+        if (ecs_os_ainc(&world->workers_waiting) == (stage_count - 1)) {
+            flecs_worker_wake(world, &world->workers_waiting);
+        }
+        flecs_worker_wait_for_epoch(world, stage, epoch);
+        return;
+    }
+
     /* Signal that thread is waiting */
     ecs_os_mutex_lock(world->sync_mutex);
+    int32_t epoch = world->sync_epoch;
     if (++world->workers_waiting == (stage_count - 1)) {
         /* Only signal main thread when all threads are waiting */
         ecs_os_cond_signal(world->sync_cond);
     }
 
-    /* Wait until main thread signals that thread can continue */
-    ecs_os_cond_wait(world->worker_cond, world->sync_mutex);
+    /* Wait until main thread signals that thread can continue. The epoch
+     * filters out spurious wakeups. */
+    while (world->sync_epoch == epoch) {
+        ecs_os_cond_wait(world->worker_cond, world->sync_mutex);
+    }
     ecs_os_mutex_unlock(world->sync_mutex);
 }
 
+/* Pin the calling worker to its CPUs. Reclaims the command queues of the
+ * stage, so that they're allocated again by the worker on its own node. */
+static
+void flecs_worker_set_affinity(
+    ecs_world_t *world,
+    ecs_stage_t *stage)
+{
+    int32_t i, count = world->worker_cpus_per_thread;
+    int32_t first = (stage->id - 1) * count;
+    int32_t *cpus = ecs_os_malloc_n(int32_t, count);
+    for (i = 0; i < count; i ++) {
+        cpus[i] = world->worker_cpus[(first + i) % world->worker_cpu_count];
+    }
+
+    ecs_os_thread_set_affinity(cpus, count);
+    ecs_os_free(cpus);
+
+    ecs_stage_shrink(stage);
+}
+
 /* Worker thread */
 static
 void* flecs_worker(void *arg) {
@@ -60196,16 +61574,35 @@ void* flecs_worker(void *arg) {
 
     ecs_dbg_2("worker %d: start", stage->id);
 
+    if (world->worker_cpu_count && ecs_os_api.thread_set_affinity_ &&
+        !ecs_using_task_threads(world)) 
+    {
+        flecs_worker_set_affinity(world, stage);
+    }
+
     /* Start worker, increase counter so main thread knows how many
      * workers are ready */
-    ecs_os_mutex_lock(world->sync_mutex);
-    world->workers_running ++;
+    if (world->worker_sync == EcsWorkerSyncAtomic) {
+        int32_t epoch = flecs_worker_load(&world->sync_epoch);
+        if (ecs_os_ainc(&world->workers_running) == (world->stage_count - 1)) {
+            flecs_worker_wake(world, &world->workers_running);
+        }
+        if (!(world->flags & EcsWorldQuitWorkers)) {
+            flecs_worker_wait_for_epoch(world, stage, epoch);
+        }
+    } else {
+        ecs_os_mutex_lock(world->sync_mutex);
+        int32_t epoch = world->sync_epoch;
+        world->workers_running ++;
 
-    if (!(world->flags & EcsWorldQuitWorkers)) {
-        ecs_os_cond_wait(world->worker_cond, world->sync_mutex);
-    }
+        while (!(world->flags & EcsWorldQuitWorkers) && 
+            world->sync_epoch == epoch) 
+        {
+            ecs_os_cond_wait(world->worker_cond, world->sync_mutex);
+        }
 
-    ecs_os_mutex_unlock(world->sync_mutex);
+        ecs_os_mutex_unlock(world->sync_mutex);
+    }
 
     while (!(world->flags & EcsWorldQuitWorkers)) {
         ecs_entity_t old_scope = ecs_set_scope((ecs_world_t*)stage, 0);
@@ -60216,14 +61613,18 @@ void* flecs_worker(void *arg) {
 
         ecs_set_scope((ecs_world_t*)stage, old_scope);
 
-        flecs_sync_worker(world);
+        flecs_sync_worker(world, stage);
     }
 
     ecs_dbg_2("worker %d: finalizing", stage->id);
 
-    ecs_os_mutex_lock(world->sync_mutex);
-    world->workers_running --;
-    ecs_os_mutex_unlock(world->sync_mutex);
+    if (world->worker_sync == EcsWorkerSyncAtomic) {
+        ecs_os_adec(&world->workers_running);
+    } else {
+        ecs_os_mutex_lock(world->sync_mutex);
+        world->workers_running --;
+        ecs_os_mutex_unlock(world->sync_mutex);
+    }
 
     ecs_dbg_2("worker %d: stop", stage->id);
 
@@ -60282,6 +61683,12 @@ void flecs_wait_for_workers(
         return;
     }
 
+    if (world->worker_sync == EcsWorkerSyncAtomic) {
+        flecs_worker_wait_for_count(world, world->stages[0], 
+            &world->workers_running, stage_count - 1);
+        return;
+    }
+
     bool wait = true;
     do {
         ecs_os_mutex_lock(world->sync_mutex);
@@ -60303,6 +61710,16 @@ void flecs_wait_for_sync(
 
     ecs_dbg_3("#[bold]pipeline: waiting for worker sync");
 
+    if (world->worker_sync == EcsWorkerSyncAtomic) {
+        flecs_worker_wait_for_count(world, world->stages[0], 
+            &world->workers_waiting, stage_count - 1);
+
+        /* Workers don't touch the counter again until they're signaled */
+        world->workers_waiting = 0;
+        ecs_dbg_3("#[bold]pipeline: workers synced");
+        return;
+    }
+
     ecs_os_mutex_lock(world->sync_mutex);
     if (world->workers_waiting != (stage_count - 1)) {
         ecs_os_cond_wait(world->sync_cond, world->sync_mutex);
@@ -60328,7 +61745,14 @@ void flecs_signal_workers(
     }
 
     ecs_dbg_3("#[bold]pipeline: signal workers");
+    if (world->worker_sync == EcsWorkerSyncAtomic) {
+        ecs_os_ainc(&world->sync_epoch);
+        flecs_worker_wake(world, &world->sync_epoch);
+        return;
+    }
+
     ecs_os_mutex_lock(world->sync_mutex);
+    world->sync_epoch ++;
     ecs_os_cond_broadcast(world->worker_cond);
     ecs_os_mutex_unlock(world->sync_mutex);
 }
@@ -60423,6 +61847,9 @@ void flecs_set_threads_internal(
             if (world->sync_cond) {
                 ecs_os_cond_free(world->sync_cond);
             }
+            if (world->park_cond) {
+                ecs_os_cond_free(world->park_cond);
+            }
             if (world->sync_mutex) {
                 ecs_os_mutex_free(world->sync_mutex);
             }
@@ -60434,6 +61861,7 @@ void flecs_set_threads_internal(
         if (threads > 1) {
             world->worker_cond = ecs_os_cond_new();
             world->sync_cond = ecs_os_cond_new();
+            world->park_cond = ecs_os_cond_new();
             world->sync_mutex = ecs_os_mutex_new();
             flecs_start_workers(world, threads);
         }
@@ -60462,6 +61890,71 @@ bool ecs_using_task_threads(
     return world->workers_use_task_api;
 }
 
+void ecs_set_worker_sync(
+    ecs_world_t *world,
+    ecs_worker_sync_t sync)
+{
+    flecs_poly_assert(world, ecs_world_t);
+    ecs_check(sync == EcsWorkerSyncMutex || sync == EcsWorkerSyncAtomic,
+        ECS_INVALID_PARAMETER, NULL);
+
+    if (world->worker_sync == (int32_t)sync) {
+        return;
+    }
+
+    /* Threads must stop and start with the same method. Task threads are
+     * created for each frame and pick up the new method by themselves. */
+    bool restart = ecs_get_stage_count(world) > 1 && 
+        !ecs_using_task_threads(world);
+    if (restart) {
+        flecs_join_worker_threads(world);
+    }
+
+    world->worker_sync = (int32_t)sync;
+
+    if (restart) {
+        flecs_create_worker_threads(world);
+    }
+error:
+    return;
+}
+
+void ecs_set_worker_affinity(
+    ecs_world_t *world,
+    const int32_t *cpus,
+    int32_t cpu_count,
+    int32_t cpus_per_worker)
+{
+    flecs_poly_assert(world, ecs_world_t);
+    ecs_check(cpu_count >= 0, ECS_INVALID_PARAMETER, NULL);
+    ecs_check(!cpu_count || cpus != NULL, ECS_INVALID_PARAMETER, NULL);
+    ecs_check(!cpu_count || cpus_per_worker > 0, 
+        ECS_INVALID_PARAMETER, NULL);
+
+    /* Workers pin themselves when they start */
+    bool restart = ecs_get_stage_count(world) > 1 && 
+        !ecs_using_task_threads(world);
+    if (restart) {
+        flecs_join_worker_threads(world);
+    }
+
+    ecs_os_free(world->worker_cpus);
+    world->worker_cpus = NULL;
+    world->worker_cpu_count = 0;
+
+    if (cpu_count) {
+        world->worker_cpus = ecs_os_memdup_n(cpus, int32_t, cpu_count);
+        world->worker_cpu_count = cpu_count;
+        world->worker_cpus_per_thread = cpus_per_worker;
+    }
+
+    if (restart) {
+        flecs_create_worker_threads(world);
+    }
+error:
+    return;
+}
+
 #endif
 
 /**
@@ -70491,6 +71984,196 @@ ecs_mixins_t ecs_system_t_mixins = {
 
 /* -- Public API -- */
 
+/* Minimum number of rows in a work stealing chunk, and the number of chunks
+ * per thread to aim for when there are enough rows. */
+#define FLECS_STEAL_MIN_CHUNK_ROWS (64)
+#define FLECS_STEAL_CHUNKS_PER_STAGE (8)
+
+/* Claim counters are padded to a cache line so that threads working through
+ * their own chunks don't contend. */
+#define FLECS_STEAL_COUNTER_STRIDE (ECS_SIZEOF(int64_t) * 8 / ECS_SIZEOF(int32_t))
+
+static
+int32_t flecs_system_steal_block(
+    const ecs_system_steal_t *steal,
+    int32_t block)
+{
+    return flecs_ito(int32_t, 
+        (int64_t)steal->chunk_count * block / steal->stage_count);
+}
+
+static
+int32_t flecs_system_steal_chunks(
+    const ecs_system_steal_t *steal,
+    int32_t row_count)
+{
+    return (row_count + steal->chunk_rows - 1) / steal->chunk_rows;
+}
+
+bool flecs_system_steal_begin(
+    ecs_world_t *world,
+    ecs_system_t *system_data,
+    int32_t stage_count)
+{
+    if (!system_data->work_stealing || !system_data->multi_threaded ||
+        system_data->run || stage_count <= 1 ||
+        !(system_data->query->flags & EcsQueryMatchThis))
+    {
+        return false;
+    }
+
+    ecs_system_steal_t *steal = system_data->steal;
+    if (!steal) {
+        steal = system_data->steal = ecs_os_calloc_t(ecs_system_steal_t);
+    }
+
+    if (steal->stage_count != stage_count) {
+        ecs_os_free(steal->claimed);
+        steal->claimed = ecs_os_malloc_n(
+            int32_t, stage_count * FLECS_STEAL_COUNTER_STRIDE);
+        steal->stage_count = stage_count;
+    }
+
+    ecs_world_t *stage = ecs_get_stage(world, 0);
+    int32_t rows = 0;
+
+    ecs_iter_t it = ecs_query_iter(stage, system_data->query);
+    it.flags |= EcsIterNoData;
+    while (ecs_query_next(&it)) {
+        rows += it.count;
+        ecs_iter_skip(&it);
+    }
+
+    int32_t target = stage_count * FLECS_STEAL_CHUNKS_PER_STAGE;
+    steal->chunk_rows = ECS_MAX(FLECS_STEAL_MIN_CHUNK_ROWS, 
+        (rows + target - 1) / target);
+
+    /* Chunks don't span tables, so count them per result */
+    steal->chunk_count = 0;
+    it = ecs_query_iter(stage, system_data->query);
+    it.flags |= EcsIterNoData;
+    while (ecs_query_next(&it)) {
+        steal->chunk_count += flecs_system_steal_chunks(steal, it.count);
+        ecs_iter_skip(&it);
+    }
+
+    int32_t i;
+    for (i = 0; i < stage_count; i ++) {
+        steal->claimed[i * FLECS_STEAL_COUNTER_STRIDE] = 0;
+    }
+
+    steal->arrived[0] = steal->arrived[1] = 0;
+    steal->active = true;
+
+    return true;
+}
+
+void flecs_system_steal_end(
+    ecs_system_t *system_data)
+{
+    if (system_data->steal) {
+        system_data->steal->active = false;
+    }
+}
+
+static
+ecs_iter_t flecs_system_iter(
+    ecs_world_t *thread_ctx,
+    ecs_entity_t system,
+    ecs_system_t *system_data,
+    ecs_ftime_t delta_time,
+    ecs_ftime_t time_elapsed,
+    void *param)
+{
+    ecs_iter_t qit = ecs_query_iter(thread_ctx, system_data->query);
+    qit.system = system;
+    qit.delta_time = delta_time;
+    qit.delta_system_time = time_elapsed;
+    qit.param = param;
+    qit.ctx = system_data->ctx;
+    qit.callback_ctx = system_data->callback_ctx;
+    qit.run_ctx = system_data->run_ctx;
+    return qit;
+}
+
+/* Run the chunks this stage claims. The claimed chunk numbers only increase,
+ * except when moving on to the blocks of stages before this one, so the query
+ * iterator is restarted at most once. */
+static
+void flecs_run_system_stealing(
+    ecs_world_t *thread_ctx,
+    ecs_entity_t system,
+    ecs_system_t *system_data,
+    int32_t stage_index,
+    ecs_ftime_t delta_time,
+    ecs_ftime_t time_elapsed,
+    void *param)
+{
+    ecs_system_steal_t *steal = system_data->steal;
+    ecs_iter_action_t action = system_data->action;
+    int32_t stage_count = steal->stage_count;
+
+    ecs_iter_t qit = flecs_system_iter(
+        thread_ctx, system, system_data, delta_time, time_elapsed, param);
+    qit.callback = action;
+    bool iterating = true;
+
+    /* Chunk numbers [first, last) belong to the current query result */
+    int32_t first = 0, last = 0;
+
+    int32_t b;
+    for (b = 0; b < stage_count; b ++) {
+        int32_t block = (stage_index + b) % stage_count;
+        int32_t block_start = flecs_system_steal_block(steal, block);
+        int32_t block_size = flecs_system_steal_block(steal, block + 1) - 
+            block_start;
+        int32_t *claimed = &steal->claimed[block * FLECS_STEAL_COUNTER_STRIDE];
+
+        if (block < stage_index && first > block_start) {
+            /* Wrapped around to the blocks before this stage's own */
+            if (iterating) {
+                ecs_iter_fini(&qit);
+            }
+            qit = flecs_system_iter(
+                thread_ctx, system, system_data, delta_time, time_elapsed, 
+                param);
+            qit.callback = action;
+            iterating = true;
+            first = last = 0;
+        }
+
+        int32_t k;
+        while ((k = ecs_os_ainc(claimed) - 1) < block_size) {
+            int32_t chunk = block_start + k;
+
+            while (chunk >= last) {
+                if (!iterating || !ecs_query_next(&qit)) {
+                    iterating = false;
+                    break;
+                }
+                first = last;
+                last = first + flecs_system_steal_chunks(steal, qit.count);
+            }
+
+            if (!iterating) {
+                break; /* Query returned fewer chunks than counted */
+            }
+
+            int32_t row = (chunk - first) * steal->chunk_rows;
+            ecs_iter_t it = qit;
+            it.offset += row;
+            it.frame_offset += row;
+            it.count = ECS_MIN(steal->chunk_rows, qit.count - row);
+            it.entities = &ecs_table_entities(it.table)[it.offset];
+            action(&it);
+        }
+    }
+
+    if (iterating) {
+        ecs_iter_fini(&qit);
+    }
+}
+
 ecs_entity_t flecs_run_system(
     ecs_world_t *world,
     ecs_stage_t *stage,
@@ -70553,24 +72236,36 @@ ecs_entity_t flecs_run_system(
 
     flecs_poly_assert(stage, ecs_stage_t);
 
+    ecs_entity_t old_system;
+
+    if (stage_count > 1 && system_data->steal && 
+        system_data->steal->active && 
+        system_data->steal->stage_count == stage_count) 
+    {
+        old_system = flecs_stage_set_system(stage, system);
+        flecs_run_system_stealing(thread_ctx, system, system_data, 
+            stage_index, delta_time, time_elapsed, param);
+        flecs_stage_set_system(stage, old_system);
+
+        if (measure_time) {
+            system_data->time_spent += (ecs_ftime_t)ecs_time_measure(&time_start);
+        }
+
+        ecs_os_perf_trace_pop(system_data->name);
+        return 0;
+    }
+
     /* Prepare the query iterator */
-    ecs_iter_t wit, qit = ecs_query_iter(thread_ctx, system_data->query);
+    ecs_iter_t wit, qit = flecs_system_iter(
+        thread_ctx, system, system_data, delta_time, time_elapsed, param);
     ecs_iter_t *it = &qit;
 
-    qit.system = system;
-    qit.delta_time = delta_time;
-    qit.delta_system_time = time_elapsed;
-    qit.param = param;
-    qit.ctx = system_data->ctx;
-    qit.callback_ctx = system_data->callback_ctx;
-    qit.run_ctx = system_data->run_ctx;
-
     if (stage_count > 1 && system_data->multi_threaded) {
         wit = ecs_worker_iter(it, stage_index, stage_count);
         it = &wit;
     }
 
-    ecs_entity_t old_system = flecs_stage_set_system(stage, system);
+    old_system = flecs_stage_set_system(stage, system);
     ecs_iter_action_t action = system_data->action;
     it->callback = action;
 
@@ -70676,6 +72371,11 @@ void flecs_system_fini(ecs_system_t *sys) {
         sys->run_ctx_free(sys->run_ctx);
     }
 
+    if (sys->steal) {
+        ecs_os_free(sys->steal->claimed);
+        ecs_os_free(sys->steal);
+    }
+
     /* Safe cast, type owns name */
     ecs_os_free(ECS_CONST_CAST(char*, sys->name));
 
@@ -70778,6 +72478,8 @@ ecs_entity_t ecs_system_init(
         system->tick_source = desc->tick_source;
 
         system->multi_threaded = desc->multi_threaded;
+        system->work_stealing = desc->work_stealing;
+        system->concurrent = desc->concurrent;
         system->immediate = desc->immediate;
 
         system->name = ecs_get_path(world, entity);
@@ -70862,6 +72564,14 @@ ecs_entity_t ecs_system_init(
             system->multi_threaded = desc->multi_threaded;
         }
 
+        if (desc->work_stealing) {
+            system->work_stealing = desc->work_stealing;
+        }
+
+        if (desc->concurrent) {
+            system->concurrent = desc->concurrent;
+        }
+
         if (desc->immediate) {
             system->immediate = desc->immediate;
         }
@@ -71006,14 +72716,19 @@ void FlecsSystemImport(
  * the order across different tables. The code will first sort the elements in
  * each matched table, and then build a list of (offset, count) slices across 
  * the matched tables that represents the correct iteration order. The algorithm
- * used for sorting is qsort.
+ * used for sorting is qsort, or a radix sort if the query provides an 
+ * order_by_key callback.
  * 
  * Resorting is a very expensive operation. Queries use change detection, which
  * at a table level can detect if any changes occurred to the entities or ordered
- * by component. Only if a change has been detected will resorting occur. Even
- * then, this remains an expensive feature and should only be used for data that
- * doesn't change often. Flecs uses the query sorting feature to ensure that
- * pipeline queries return systems in a well defined order.
+ * by component. Only if a change has been detected will resorting occur. Since
+ * a changed table is often still mostly sorted, the rows that are out of order
+ * are first looked up in a single pass. If there are only a few, they are 
+ * sorted and merged back into the table, and only tables with many changed rows
+ * are fully resorted. Even then, this remains an expensive feature and should
+ * only be used for data that doesn't change often. Flecs uses the query sorting
+ * feature to ensure that pipeline queries return systems in a well defined 
+ * order.
  * 
  * The sorted list of slices is stored in the table_slices member of the cache,
  * and is only populated for sorted queries.
@@ -71162,6 +72877,189 @@ bool flecs_query_cache_match_table(
     return true;
 }
 
+/* Find an id that a table must have in its records to match the cache. Caches
+ * with such an id are only offered new tables with the id, instead of every
+ * table that has an id of one of the query terms. If there are multiple
+ * candidates, the id with the fewest tables is the least likely to be in a new
+ * table. Ties (typically ids that don't have tables yet) go to the id with the
+ * fewest caches in the index. Returns 0 if the query has no such id. */
+static
+ecs_id_t flecs_query_cache_index_id(
+    ecs_world_t *world,
+    const ecs_query_t *q)
+{
+    ecs_map_t *index = &world->query_index;
+    ecs_id_t result = 0;
+    int32_t i, min_count = INT32_MAX, min_caches = INT32_MAX;
+
+    for (i = 0; i < q->term_count; i ++) {
+        const ecs_term_t *term = &q->terms[i];
+        if (term->oper != EcsAnd || term->flags_ & EcsTermIsOr) {
+            continue;
+        }
+
+        if (!ecs_term_match_this(term)) {
+            continue;
+        }
+
+        if ((term->src.id & EcsTraverseFlags) != EcsSelf) {
+            continue;
+        }
+
+        ecs_id_t id = term->id;
+        if (ECS_IS_PAIR(id)) {
+            ecs_entity_t first = ECS_PAIR_FIRST(id);
+            ecs_entity_t second = ECS_PAIR_SECOND(id);
+            if (first == EcsAny) {
+                first = EcsWildcard;
+            }
+            if (second == EcsAny) {
+                second = EcsWildcard;
+            }
+            if (first == EcsWildcard && second == EcsWildcard) {
+                continue;
+            }
+            id = ecs_pair(first, second);
+        } else if (ecs_id_is_wildcard(id)) {
+            continue;
+        }
+
+        int32_t count = 0;
+        ecs_component_record_t *cr = flecs_components_get(world, id);
+        if (cr) {
+            if (cr->flags & (EcsIdDontFragment|EcsIdMatchDontFragment)) {
+                continue;
+            }
+            count = cr->cache.tables.count;
+        }
+
+        if (count > min_count) {
+            continue;
+        }
+
+        int32_t caches = 0;
+        if (ecs_map_is_init(index)) {
+            ecs_vec_t *v = ecs_map_get_deref(index, ecs_vec_t, id);
+            caches = v ? ecs_vec_count(v) : 0;
+        }
+
+        if (count < min_count || caches < min_caches) {
+            min_count = count;
+            min_caches = caches;
+            result = id;
+        }
+    }
+
+    return result;
+}
+
+static
+void flecs_query_cache_index_register(
+    ecs_world_t *world,
+    ecs_query_cache_t *cache)
+{
+    ecs_map_t *index = &world->query_index;
+    ecs_map_init_if(index, &world->allocator);
+    ecs_vec_t *caches = ecs_map_ensure_alloc_t(index, ecs_vec_t, 
+        cache->index_id);
+    ecs_vec_init_if_t(caches, ecs_query_cache_t*);
+    ecs_query_cache_t **elem = ecs_vec_append_t(
+        &world->allocator, caches, ecs_query_cache_t*);
+    *elem = cache;
+}
+
+static
+void flecs_query_cache_index_unregister(
+    ecs_world_t *world,
+    ecs_query_cache_t *cache)
+{
+    ecs_map_t *index = &world->query_index;
+    ecs_vec_t *caches = ecs_map_get_deref(index, ecs_vec_t, cache->index_id);
+    ecs_assert(caches != NULL, ECS_INTERNAL_ERROR, NULL);
+
+    int32_t i, count = ecs_vec_count(caches);
+    ecs_query_cache_t **elems = ecs_vec_first(caches);
+    for (i = 0; i < count; i ++) {
+        if (elems[i] == cache) {
+            ecs_vec_remove_t(caches, ecs_query_cache_t*, i);
+            count --;
+            break;
+        }
+    }
+
+    if (!count) {
+        ecs_vec_fini_t(&world->allocator, caches, ecs_query_cache_t*);
+        ecs_map_remove_free(index, cache->index_id);
+    }
+
+    if (!ecs_map_count(index)) {
+        ecs_map_fini(index);
+    }
+}
+
+/* Same filter as flecs_ignore_observer applies to the cache observer for caches
+ * that aren't in the index. */
+static
+bool flecs_query_cache_ignore_table(
+    const ecs_query_cache_t *cache,
+    const ecs_table_t *table)
+{
+    ecs_flags32_t observer_flags = flecs_observer_impl(cache->observer)->flags;
+    if (observer_flags & (EcsObserverIsDisabled|EcsObserverIsParentDisabled)) {
+        return true;
+    }
+
+    ecs_flags32_t table_flags = table->flags;
+    ecs_flags32_t query_flags = cache->query->flags;
+    if ((table_flags & EcsTableIsPrefab) && 
+        !(query_flags & EcsQueryMatchPrefab)) 
+    {
+        return true;
+    }
+
+    return (table_flags & EcsTableIsDisabled) && 
+        !(query_flags & EcsQueryMatchDisabled);
+}
+
+void flecs_query_cache_match_new_table(
+    ecs_world_t *world,
+    ecs_table_t *table)
+{
+    ecs_map_t *index = &world->query_index;
+    if (!ecs_map_is_init(index)) {
+        return;
+    }
+
+    const ecs_table_record_t *records = table->_->records;
+    int32_t i, count = table->_->record_count;
+    for (i = 0; i < count; i ++) {
+        ecs_vec_t *caches = ecs_map_get_deref(
+            index, ecs_vec_t, records[i].hdr.cr->id);
+        if (!caches) {
+            continue;
+        }
+
+        /* Don't cache the array, group callbacks could create new queries */
+        int32_t c;
+        for (c = 0; c < ecs_vec_count(caches); c ++) {
+            ecs_query_cache_t *cache = 
+                ecs_vec_get_t(caches, ecs_query_cache_t*, c)[0];
+            if (flecs_query_cache_ignore_table(cache, table)) {
+                continue;
+            }
+
+            if (flecs_query_cache_match_table(world, cache, table)) {
+                if (ecs_should_log_3()) {
+                    char *table_str = ecs_table_str(world, table);
+                    ecs_dbg_3("query cache event: OnTableCreate for [%s]", 
+                        table_str);
+                    ecs_os_free(table_str);
+                }
+            }
+        }
+    }
+}
+
 /* Iterate component monitors for cache. Each field that could potentially cause
  * up traversal will create a monitor. Component monitors are registered with 
  * the world and are used to determine whether a rematch is necessary. */
@@ -71242,7 +73140,8 @@ int flecs_query_cache_order_by(
     ecs_query_impl_t *impl,
     ecs_entity_t order_by,
     ecs_order_by_action_t order_by_callback,
-    ecs_sort_table_action_t action)
+    ecs_sort_table_action_t action,
+    ecs_order_by_key_action_t key)
 {
     ecs_check(impl != NULL, ECS_INVALID_PARAMETER, NULL);
     ecs_query_cache_t *cache = impl->cache;
@@ -71278,6 +73177,7 @@ int flecs_query_cache_order_by(
     cache->order_by_callback = order_by_callback;
     cache->order_by_term = order_by_term;
     cache->order_by_table_callback = action;
+    cache->order_by_key = key;
 
     ecs_vec_fini_t(NULL, &cache->table_slices, ecs_query_cache_match_t);
     flecs_query_cache_sort_tables(world, impl);
@@ -71425,6 +73325,10 @@ void flecs_query_cache_fini(
         flecs_observer_fini(cache->observer);
     }
 
+    if (cache->index_id) {
+        flecs_query_cache_index_unregister(world, cache);
+    }
+
     ecs_group_delete_action_t on_delete = cache->on_group_delete;
     if (on_delete) {
         ecs_map_iter_t it = ecs_map_iter(&cache->groups);
@@ -71598,8 +73502,14 @@ ecs_query_cache_t* flecs_query_cache_init(
         observer_desc.run = flecs_query_cache_on_event;
         observer_desc.ctx = impl;
 
+        /* If the cache can be found through the query index, new tables are
+         * matched by flecs_query_cache_match_new_table. */
+        result->index_id = flecs_query_cache_index_id(world, result->query);
+
         int32_t event_index = 0;
-        observer_desc.events[event_index ++] = EcsOnTableCreate;
+        if (!result->index_id) {
+            observer_desc.events[event_index ++] = EcsOnTableCreate;
+        }
         observer_desc.events[event_index ++] = EcsOnTableDelete;
         observer_desc.flags_ = EcsObserverBypassQuery;
 
@@ -71613,6 +73523,10 @@ ecs_query_cache_t* flecs_query_cache_init(
         if (!result->observer) {
             goto error;
         }
+
+        if (result->index_id) {
+            flecs_query_cache_index_register(world, result);
+        }
     }
 
     result->prev_match_count = -1;
@@ -71655,7 +73569,7 @@ ecs_query_cache_t* flecs_query_cache_init(
     if (const_desc->order_by_callback) {
         if (flecs_query_cache_order_by(world, impl, 
             const_desc->order_by, const_desc->order_by_callback,
-            const_desc->order_by_table_callback))
+            const_desc->order_by_table_callback, const_desc->order_by_key))
         {
             goto error;
         }
@@ -73552,6 +75466,399 @@ done:
 
 ECS_SORT_TABLE_WITH_COMPARE(_, flecs_query_cache_sort_table_generic, order_by, static)
 
+/* Minimum number of rows to sort before tables are sorted on multiple threads */
+#define FLECS_QUERY_SORT_TASK_MIN_ROWS (16 * 1024)
+
+/* Tables with more than 1 / RATIO of their rows out of order are resorted
+ * entirely, instead of only sorting & merging the rows that are out of order */
+#define FLECS_QUERY_SORT_INCREMENTAL_RATIO (8)
+
+/* Sort key for a table row, used when query has order_by_key */
+typedef struct sort_key_t {
+    uint64_t key;
+    int32_t row;
+} sort_key_t;
+
+/* Rows of a table to sort with order_by_callback */
+typedef struct sort_rows_t {
+    ecs_entity_t *entities;
+    void *ptr;
+    int32_t size;
+    ecs_order_by_action_t compare;
+} sort_rows_t;
+
+/* Table to sort with order_by_key */
+typedef struct sort_job_t {
+    ecs_table_t *table;
+    int32_t column;
+    bool permuted;
+} sort_job_t;
+
+/* Tables to sort, claimed one at a time by sort tasks */
+typedef struct sort_jobs_t {
+    ecs_world_t *world;
+    ecs_order_by_key_action_t key;
+    sort_job_t *jobs;
+    int32_t count;
+    int32_t next;
+} sort_jobs_t;
+
+uint64_t ecs_order_by_key_f32(
+    float value)
+{
+    uint32_t bits;
+    ecs_os_memcpy(&bits, &value, ECS_SIZEOF(float));
+    /* Flip all bits of negative values, and only the sign of positive values */
+    bits ^= (bits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+    return bits;
+}
+
+uint64_t ecs_order_by_key_f64(
+    double value)
+{
+    uint64_t bits;
+    ecs_os_memcpy(&bits, &value, ECS_SIZEOF(double));
+    bits ^= (bits & 0x8000000000000000ull) ? 
+        0xFFFFFFFFFFFFFFFFull : 0x8000000000000000ull;
+    return bits;
+}
+
+uint64_t ecs_order_by_key_i64(
+    int64_t value)
+{
+    return (uint64_t)value ^ 0x8000000000000000ull;
+}
+
+/* Stable LSD radix sort on 8 bit digits. Digits that are the same for all keys
+ * are skipped, so keys with a small range only take a few passes. Returns the
+ * buffer with the sorted keys, which is either keys or tmp. */
+static
+sort_key_t* flecs_query_cache_radix_sort(
+    sort_key_t *keys,
+    sort_key_t *tmp,
+    int32_t count)
+{
+    int32_t hist[8][256];
+    int32_t i, d, b;
+    ecs_os_memset(hist, 0, ECS_SIZEOF(hist));
+
+    for (i = 0; i < count; i ++) {
+        uint64_t key = keys[i].key;
+        for (d = 0; d < 8; d ++) {
+            hist[d][(key >> (d * 8)) & 0xFF] ++;
+        }
+    }
+
+    for (d = 0; d < 8; d ++) {
+        int32_t *h = hist[d];
+        int32_t shift = d * 8;
+        if (h[(keys[0].key >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        int32_t offset = 0;
+        for (b = 0; b < 256; b ++) {
+            int32_t n = h[b];
+            h[b] = offset;
+            offset += n;
+        }
+
+        for (i = 0; i < count; i ++) {
+            tmp[h[(keys[i].key >> shift) & 0xFF] ++] = keys[i];
+        }
+
+        sort_key_t *t = keys;
+        keys = tmp;
+        tmp = t;
+    }
+
+    return keys;
+}
+
+/* Find rows that are out of order by removing both rows of each descent, which
+ * leaves a sorted sequence of kept rows. If few enough rows were removed, sort
+ * them and merge them with the kept rows. Returns the new order of the table,
+ * or NULL if too many rows are out of order. */
+static
+int32_t* flecs_query_cache_sort_keys_incremental(
+    sort_key_t *keys,
+    sort_key_t *tmp,
+    int32_t count)
+{
+    int32_t max_displaced = count / FLECS_QUERY_SORT_INCREMENTAL_RATIO;
+    int32_t i, kept = 0, displaced = 0;
+
+    /* Kept rows are stored at the start of tmp, removed rows at the end */
+    for (i = 0; i < count; i ++) {
+        if (!kept || (tmp[kept - 1].key <= keys[i].key)) {
+            tmp[kept ++] = keys[i];
+            continue;
+        }
+
+        displaced += 2;
+        if (displaced > max_displaced) {
+            return NULL;
+        }
+
+        kept --;
+        tmp[count - displaced + 1] = tmp[kept];
+        tmp[count - displaced] = keys[i];
+    }
+
+    /* Keys are no longer used, so they can hold the removed rows while they're
+     * sorted. Both buffers fit as there are at most count / RATIO rows. */
+    ecs_os_memcpy_n(keys, &tmp[count - displaced], sort_key_t, displaced);
+    sort_key_t *removed = flecs_query_cache_radix_sort(
+        keys, &keys[displaced], displaced);
+
+    int32_t *order = ecs_os_malloc_n(int32_t, count);
+    int32_t k = 0, r = 0;
+    for (i = 0; i < count; i ++) {
+        if ((r == displaced) || 
+            ((k < kept) && (tmp[k].key <= removed[r].key))) 
+        {
+            order[i] = tmp[k ++].row;
+        } else {
+            order[i] = removed[r ++].row;
+        }
+    }
+
+    return order;
+}
+
+/* Sort table by radix sorting keys, then move rows into the sorted order. Can
+ * run in parallel for different tables. Returns whether the table changed. */
+static
+bool flecs_query_cache_sort_table_by_key(
+    ecs_world_t *world,
+    ecs_table_t *table,
+    int32_t column_index,
+    ecs_order_by_key_action_t key)
+{
+    int32_t i, count = ecs_table_count(table);
+    if (count < 2) {
+        return false;
+    }
+
+    ecs_entity_t *entities = table->data.entities;
+    void *ptr = NULL;
+    ecs_size_t size = 0;
+    if (column_index != -1) {
+        ecs_column_t *column = &table->data.columns[column_index];
+        size = column->ti->size;
+        ptr = column->data;
+    }
+
+    sort_key_t *keys = ecs_os_malloc_n(sort_key_t, count * 2);
+    bool sorted = true;
+    for (i = 0; i < count; i ++) {
+        keys[i].key = key(entities[i], ECS_ELEM(ptr, size, i));
+        keys[i].row = i;
+        sorted &= !i || (keys[i - 1].key <= keys[i].key);
+    }
+
+    /* Tables that are resorted every frame are often still sorted */
+    if (!sorted) {
+        sort_key_t *tmp = &keys[count];
+        int32_t *order = flecs_query_cache_sort_keys_incremental(
+            keys, tmp, count);
+        if (order) {
+            flecs_table_permute(world, table, order);
+            ecs_os_free(order);
+        } else {
+            sort_key_t *result = flecs_query_cache_radix_sort(
+                keys, tmp, count);
+
+            /* Store order in the buffer that doesn't hold the result */
+            order = (int32_t*)(result == keys ? tmp : keys);
+            for (i = 0; i < count; i ++) {
+                order[i] = result[i].row;
+            }
+
+            flecs_table_permute(world, table, order);
+        }
+    }
+
+    ecs_os_free(keys);
+
+    return !sorted;
+}
+
+static
+void* flecs_query_cache_sort_task(
+    void *arg)
+{
+    sort_jobs_t *jobs = arg;
+    int32_t i;
+    while ((i = ecs_os_ainc(&jobs->next) - 1) < jobs->count) {
+        sort_job_t *job = &jobs->jobs[i];
+        job->permuted = flecs_query_cache_sort_table_by_key(
+            jobs->world, job->table, job->column, jobs->key);
+    }
+    return NULL;
+}
+
+/* Sort tables with order_by_key. If there's enough to sort and the world has
+ * multiple stages, tables are divided across task threads. */
+static
+void flecs_query_cache_sort_tables_by_key(
+    ecs_world_t *world,
+    ecs_order_by_key_action_t key,
+    ecs_vec_t *to_sort)
+{
+    int32_t i, count = ecs_vec_count(to_sort);
+    if (!count) {
+        return;
+    }
+
+    sort_jobs_t jobs = {
+        .world = world,
+        .key = key,
+        .jobs = ecs_vec_first(to_sort),
+        .count = count
+    };
+
+    int32_t rows = 0;
+    for (i = 0; i < count; i ++) {
+        rows += ecs_table_count(jobs.jobs[i].table);
+    }
+
+    int32_t task_count = 0;
+    if (rows >= FLECS_QUERY_SORT_TASK_MIN_ROWS && ecs_os_has_task_support()) {
+        task_count = ECS_MIN(ecs_get_stage_count(world), count) - 1;
+    }
+
+    ecs_os_thread_t *tasks = NULL;
+    if (task_count > 0) {
+        tasks = flecs_alloc_n(&world->allocator, ecs_os_thread_t, task_count);
+        for (i = 0; i < task_count; i ++) {
+            tasks[i] = ecs_os_task_new(flecs_query_cache_sort_task, &jobs);
+        }
+    }
+
+    flecs_query_cache_sort_task(&jobs);
+
+    if (task_count > 0) {
+        for (i = 0; i < task_count; i ++) {
+            ecs_os_task_join(tasks[i]);
+        }
+        flecs_free_n(&world->allocator, ecs_os_thread_t, task_count, tasks);
+    }
+
+    /* Table versions are stored in the world, so update them after tasks are
+     * done to prevent tasks from writing to the same version */
+    for (i = 0; i < count; i ++) {
+        if (jobs.jobs[i].permuted) {
+            flecs_table_mark_table_dirty(world, jobs.jobs[i].table, 0);
+        }
+    }
+}
+
+static
+int flecs_query_cache_compare_rows(
+    const sort_rows_t *rows,
+    int32_t row_1,
+    int32_t row_2)
+{
+    return rows->compare(
+        rows->entities[row_1], ECS_ELEM(rows->ptr, rows->size, row_1),
+        rows->entities[row_2], ECS_ELEM(rows->ptr, rows->size, row_2));
+}
+
+/* Stable merge sort for a list of rows */
+static
+void flecs_query_cache_sort_rows(
+    const sort_rows_t *rows,
+    int32_t *elems,
+    int32_t *tmp,
+    int32_t count)
+{
+    if (count < 2) {
+        return;
+    }
+
+    int32_t half = count / 2;
+    flecs_query_cache_sort_rows(rows, elems, tmp, half);
+    flecs_query_cache_sort_rows(rows, &elems[half], tmp, count - half);
+
+    int32_t i, l = 0, r = half;
+    for (i = 0; i < count; i ++) {
+        if ((r == count) || ((l < half) && 
+            flecs_query_cache_compare_rows(rows, elems[l], elems[r]) <= 0)) 
+        {
+            tmp[i] = elems[l ++];
+        } else {
+            tmp[i] = elems[r ++];
+        }
+    }
+
+    ecs_os_memcpy_n(elems, tmp, int32_t, count);
+}
+
+/* Same as flecs_query_cache_sort_keys_incremental, but for tables that are
+ * sorted with order_by_callback. Returns false if the table has too many rows
+ * that are out of order, in which case it must be sorted entirely. */
+static
+bool flecs_query_cache_sort_table_incremental(
+    ecs_world_t *world,
+    ecs_table_t *table,
+    const sort_rows_t *rows)
+{
+    int32_t i, count = ecs_table_count(table);
+    int32_t max_displaced = count / FLECS_QUERY_SORT_INCREMENTAL_RATIO;
+    int32_t kept = 0, displaced = 0;
+
+    /* Kept rows are stored at the start of elems, removed rows at the end. The
+     * second half of the buffer is used for the new order of the table. */
+    int32_t *elems = ecs_os_malloc_n(int32_t, count * 2);
+    int32_t *order = &elems[count];
+    bool result = true;
+
+    for (i = 0; i < count; i ++) {
+        if (!kept || 
+            flecs_query_cache_compare_rows(rows, elems[kept - 1], i) <= 0) 
+        {
+            elems[kept ++] = i;
+            continue;
+        }
+
+        displaced += 2;
+        if (displaced > max_displaced) {
+            result = false;
+            goto done;
+        }
+
+        kept --;
+        elems[count - displaced + 1] = elems[kept];
+        elems[count - displaced] = i;
+    }
+
+    if (!displaced) {
+        goto done;
+    }
+
+    int32_t *removed = &elems[count - displaced];
+    flecs_query_cache_sort_rows(rows, removed, order, displaced);
+
+    int32_t k = 0, r = 0;
+    for (i = 0; i < count; i ++) {
+        if ((r == displaced) || ((k < kept) && 
+            flecs_query_cache_compare_rows(rows, elems[k], removed[r]) <= 0))
+        {
+            order[i] = elems[k ++];
+        } else {
+            order[i] = removed[r ++];
+        }
+    }
+
+    flecs_table_permute(world, table, order);
+    flecs_table_mark_table_dirty(world, table, 0);
+
+done:
+    ecs_os_free(elems);
+    return result;
+}
+
 static
 void flecs_query_cache_sort_table(
     ecs_world_t *world,
@@ -73580,6 +75887,11 @@ void flecs_query_cache_sort_table(
         ptr = column->data;
     }
 
+    sort_rows_t rows = { entities, ptr, size, compare };
+    if (flecs_query_cache_sort_table_incremental(world, table, &rows)) {
+        return;
+    }
+
     if (sort) {
         sort(world, table, entities, ptr, size, 0, count - 1, compare);
     } else {
@@ -73781,10 +76093,16 @@ void flecs_query_cache_sort_tables(
     }
 
     ecs_sort_table_action_t sort = cache->order_by_table_callback;
+    ecs_order_by_key_action_t key = cache->order_by_key;
     ecs_entity_t order_by = cache->order_by;
     int32_t order_by_term = cache->order_by_term;
     ecs_component_record_t *cr = flecs_components_get(world, order_by);
 
+    /* Tables that are sorted with order_by_key are collected first, so they
+     * can be sorted in parallel */
+    ecs_vec_t to_sort;
+    ecs_vec_init_t(&world->allocator, &to_sort, sort_job_t, 0);
+
     /* Iterate over non-empty tables. Don't bother with empty tables as they
      * have nothing to sort */
 
@@ -73847,13 +76165,26 @@ void flecs_query_cache_sort_tables(
                 continue;
             }
 
+            tables_sorted = true;
+
+            if (key) {
+                sort_job_t *job = ecs_vec_append_t(
+                    &world->allocator, &to_sort, sort_job_t);
+                job->table = table;
+                job->column = column;
+                job->permuted = false;
+                continue;
+            }
+
             /* Something has changed, sort the table. Prefers using 
             * flecs_query_cache_sort_table when available */
             flecs_query_cache_sort_table(world, table, column, compare, sort);
-            tables_sorted = true;
         }
     } while ((cur = cur->next)); /* Next group */
 
+    flecs_query_cache_sort_tables_by_key(world, key, &to_sort);
+    ecs_vec_fini_t(&world->allocator, &to_sort, sort_job_t);
+
     if (tables_sorted || cache->match_count != cache->prev_match_count) {
         flecs_query_cache_build_sorted_tables(cache);
         cache->match_count ++; /* Increase version if tables changed */
@@ -76584,7 +78915,11 @@ bool flecs_query_with(
             }
         }
 
-        tr = flecs_component_get_table(cr, table);
+        if (ecs_id_is_wildcard(id)) {
+            tr = flecs_component_get_table(cr, table);
+        } else {
+            tr = flecs_table_get_record(ctx->world, table, id);
+        }
         if (!tr) {
             return false;
         }
@@ -81815,7 +84150,7 @@ bool flecs_query_trivial_search(
         return false;
     }
 
-    uint64_t q_filter = q->bloom_filter;
+    const uint64_t *q_filter = q->bloom_filter;
 
     do {
         const ecs_table_record_t *tr = flecs_table_cache_next(
@@ -81839,13 +84174,8 @@ bool flecs_query_trivial_search(
             }
 
             const ecs_term_t *term = &terms[t];
-            ecs_component_record_t *cr = flecs_components_get(ctx->world, term->id);
-            if (!cr) {
-                break;
-            }
-
-            const ecs_table_record_t *tr_with = flecs_component_get_table(
-                cr, table);
+            const ecs_table_record_t *tr_with = flecs_table_get_record(
+                ctx->world, table, term->id);
             if (!tr_with) {
                 break;
             }
@@ -81880,7 +84210,7 @@ bool flecs_query_is_trivial_search(
         return false;
     }
 
-    uint64_t q_filter = q->bloom_filter;
+    const uint64_t *q_filter = q->bloom_filter;
 
 next:
     {
@@ -81900,13 +84230,8 @@ next:
         }
 
         for (t = 1; t < term_count; t ++) {
-            ecs_component_record_t *cr = flecs_components_get(ctx->world, ids[t]);
-            if (!cr) {
-                return false;
-            }
-
-            const ecs_table_record_t *tr_with = flecs_component_get_table(
-                cr, table);
+            const ecs_table_record_t *tr_with = flecs_table_get_record(
+                ctx->world, table, ids[t]);
             if (!tr_with) {
                 goto next;
             }
@@ -81951,12 +84276,8 @@ bool flecs_query_trivial_test(
             }
 
             const ecs_term_t *term = &terms[t];
-            ecs_component_record_t *cr = flecs_components_get(q->world, term->id);
-            if (!cr) {
-                return false;
-            }
-
-            const ecs_table_record_t *tr = flecs_component_get_table(cr, table);
+            const ecs_table_record_t *tr = flecs_table_get_record(
+                q->world, table, term->id);
             if (!tr) {
                 return false;
             }
@@ -245,6 +245,7 @@
 #define FLECS_ENTITY_PAGE_BITS (6)
 #define FLECS_USE_OS_ALLOC
 #define FLECS_DEFAULT_TO_UNCACHED_QUERIES
+#define FLECS_BLOOM_FILTER_WORDS (1)
 #endif
 
 /** @def FLECS_HI_COMPONENT_ID
@@ -275,6 +276,18 @@
 #define FLECS_HI_ID_RECORD_ID (1024)
 #endif
 
+/** @def FLECS_BLOOM_FILTER_WORDS
+ * Number of 64-bit words in the bloom filters that tables and queries use to
+ * quickly discard tables that can't match a query. A filter with more bits
+ * saturates later in applications with many component ids, at the cost
+ * of a larger table and query header.
+ * 
+ * This value must be set to a value that is a power of 2.
+ */
+#ifndef FLECS_BLOOM_FILTER_WORDS
+#define FLECS_BLOOM_FILTER_WORDS (4)
+#endif
+
 /** @def FLECS_SPARSE_PAGE_BITS
  * This constant is used to determine the number of bits of an id that is used
  * to determine the page index when used with a sparse set. The number of bits
@@ -2417,6 +2430,13 @@ void* (*ecs_os_api_thread_join_t)(
 typedef
 ecs_os_thread_id_t (*ecs_os_api_thread_self_t)(void);
 
+/** OS API thread_set_affinity function type. Restricts the calling thread to
+ * the specified CPUs. */
+typedef
+void (*ecs_os_api_thread_set_affinity_t)(
+    const int32_t *cpus,
+    int32_t count);
+
 /** OS API task_new function type. */
 typedef
 ecs_os_thread_t (*ecs_os_api_task_new_t)(
@@ -2487,6 +2507,20 @@ void (*ecs_os_api_cond_wait_t)(
     ecs_os_cond_t cond,
     ecs_os_mutex_t mutex);
 
+/* Futex */
+/** OS API futex_wait function type.
+ * Blocks while *value equals expected. May return spuriously. */
+typedef
+void (*ecs_os_api_futex_wait_t)(
+    int32_t *value,
+    int32_t expected);
+
+/** OS API futex_wake function type.
+ * Wakes all threads blocked in futex_wait on value. */
+typedef
+void (*ecs_os_api_futex_wake_t)(
+    int32_t *value);
+
 /** OS API sleep function type. */
 typedef
 void (*ecs_os_api_sleep_t)(
@@ -2569,6 +2603,7 @@ typedef struct ecs_os_api_t {
     ecs_os_api_thread_new_t thread_new_;           /**< thread_new callback. */
     ecs_os_api_thread_join_t thread_join_;         /**< thread_join callback. */
     ecs_os_api_thread_self_t thread_self_;         /**< thread_self callback. */
+    ecs_os_api_thread_set_affinity_t thread_set_affinity_; /**< thread_set_affinity callback. */
 
     /* Tasks */
     ecs_os_api_thread_new_t task_new_;             /**< task_new callback. */
@@ -2593,6 +2628,10 @@ typedef struct ecs_os_api_t {
     ecs_os_api_cond_broadcast_t cond_broadcast_;   /**< cond_broadcast callback. */
     ecs_os_api_cond_wait_t cond_wait_;             /**< cond_wait callback. */
 
+    /* Futex (optional) */
+    ecs_os_api_futex_wait_t futex_wait_;           /**< futex_wait callback. */
+    ecs_os_api_futex_wake_t futex_wake_;           /**< futex_wake callback. */
+
     /* Time */
     ecs_os_api_sleep_t sleep_;                     /**< sleep callback. */
     ecs_os_api_now_t now_;                         /**< now callback. */
@@ -2789,6 +2828,7 @@ void ecs_os_set_api_defaults(void);
 #define ecs_os_thread_new(callback, param) ecs_os_api.thread_new_(callback, param)
 #define ecs_os_thread_join(thread) ecs_os_api.thread_join_(thread)
 #define ecs_os_thread_self() ecs_os_api.thread_self_()
+#define ecs_os_thread_set_affinity(cpus, count) ecs_os_api.thread_set_affinity_(cpus, count)
 
 /* Tasks */
 #define ecs_os_task_new(callback, param) ecs_os_api.task_new_(callback, param)
@@ -2813,6 +2853,10 @@ void ecs_os_set_api_defaults(void);
 #define ecs_os_cond_broadcast(cond) ecs_os_api.cond_broadcast_(cond)
 #define ecs_os_cond_wait(cond, mutex) ecs_os_api.cond_wait_(cond, mutex)
 
+/* Futex */
+#define ecs_os_futex_wait(value, expected) ecs_os_api.futex_wait_(value, expected)
+#define ecs_os_futex_wake(value) ecs_os_api.futex_wake_(value)
+
 /* Time */
 #define ecs_os_sleep(sec, nanosec) ecs_os_api.sleep_(sec, nanosec)
 #define ecs_os_now() ecs_os_api.now_()
@@ -3301,6 +3345,13 @@ typedef void (*ecs_sort_table_action_t)(
     int32_t hi,
     ecs_order_by_action_t order_by);
 
+/** Callback used for computing the sort key of a component. Keys are compared
+ * as unsigned integers, and must be in the same order as the values are when
+ * compared with the order_by callback. */
+typedef uint64_t (*ecs_order_by_key_action_t)(
+    ecs_entity_t e,
+    const void *ptr);
+
 /** Callback used for grouping tables in a query */
 typedef uint64_t (*ecs_group_by_action_t)(
     ecs_world_t *world,
@@ -3526,7 +3577,7 @@ struct ecs_query_t {
     int32_t *sizes;             /**< Component sizes. Indexed by field */
     ecs_id_t *ids;              /**< Component ids. Indexed by field */
 
-    uint64_t bloom_filter;      /**< Bitmask used to quickly discard tables */
+    uint64_t bloom_filter[FLECS_BLOOM_FILTER_WORDS]; /**< Bitmask used to quickly discard tables */
     ecs_flags32_t flags;        /**< Query flags */
     int8_t var_count;           /**< Number of query variables */
     int8_t term_count;          /**< Number of query terms */
@@ -5001,6 +5052,13 @@ typedef struct ecs_query_desc_t {
      * but more efficient. */
     ecs_sort_table_action_t order_by_table_callback;
 
+    /** Callback that returns a sort key for the order_by component. When set,
+     * tables are sorted by radix sorting the keys and then moving each column
+     * into the sorted order in a single pass, which is faster than swapping
+     * rows for large tables. Must produce the same order as order_by_callback,
+     * which is still required. */
+    ecs_order_by_key_action_t order_by_key;
+
     /** Component to sort on, used together with order_by_callback or
      * order_by_table_callback. */
     ecs_entity_t order_by;
@@ -8603,6 +8661,38 @@ FLECS_API
 int32_t ecs_query_match_count(
     const ecs_query_t *query);
 
+/** Convert a float to a sort key.
+ * Can be used to implement an order_by_key callback. Keys of larger values
+ * are larger, and negative values are ordered before positive values.
+ *
+ * @param value The value.
+ * @return The sort key.
+ */
+FLECS_API
+uint64_t ecs_order_by_key_f32(
+    float value);
+
+/** Convert a double to a sort key.
+ * Same as ecs_order_by_key_f32(), but for doubles.
+ *
+ * @param value The value.
+ * @return The sort key.
+ */
+FLECS_API
+uint64_t ecs_order_by_key_f64(
+    double value);
+
+/** Convert a signed integer to a sort key.
+ * Can be used to implement an order_by_key callback. Unsigned integers can be
+ * used as key without conversion.
+ *
+ * @param value The value.
+ * @return The sort key.
+ */
+FLECS_API
+uint64_t ecs_order_by_key_i64(
+    int64_t value);
+
 /** Convert query to a string.
  * This will convert the query program to a string which can aid in debugging
  * the behavior of a query.
@@ -12691,6 +12781,59 @@ FLECS_API
 bool ecs_using_task_threads(
     ecs_world_t *world);
 
+/** Methods for synchronizing worker threads, see ecs_set_worker_sync(). */
+typedef enum ecs_worker_sync_t {
+    EcsWorkerSyncMutex,     /**< Mutex and condition variables (default). */
+    EcsWorkerSyncAtomic     /**< Atomic counters, threads spin briefly then park. */
+} ecs_worker_sync_t;
+
+/** Set how worker threads synchronize with the main thread.
+ * With EcsWorkerSyncMutex every sync point takes the world's sync mutex and
+ * wakes workers with a condition variable broadcast. With EcsWorkerSyncAtomic
+ * workers and the main thread signal each other with atomic counters and spin
+ * for a short while before parking, which avoids the mutex and most system
+ * calls when sync points follow each other quickly, at the cost of some
+ * spinning when they don't. Parked threads use the futex_wait_ and
+ * futex_wake_ OS API callbacks when available, and fall back to a condition
+ * variable otherwise.
+ * 
+ * The operation may be called before or after ecs_set_threads(), but never
+ * while running a system / pipeline. Running worker threads are restarted.
+ * 
+ * @param world The world.
+ * @param sync The synchronization method.
+ */
+FLECS_API
+void ecs_set_worker_sync(
+    ecs_world_t *world,
+    ecs_worker_sync_t sync);
+
+/** Pin worker threads to CPUs.
+ * Each worker thread is restricted to cpus_per_worker CPUs from the cpus 
+ * array, starting at (stage - 1) * cpus_per_worker and wrapping around, so
+ * passing the cores of one NUMA node with cpus_per_worker set to 1 pins each
+ * worker to its own core on that node. The main thread is not pinned.
+ * 
+ * A worker pins itself before it starts, so memory it allocates afterwards,
+ * such as its command queues, is placed on its node by the OS. Passing a
+ * cpu_count of 0 removes the affinity. Requires the thread_set_affinity_
+ * OS API callback, and has no effect on task threads.
+ * 
+ * The operation may be called before or after ecs_set_threads(), but never
+ * while running a system / pipeline. Running worker threads are restarted.
+ * 
+ * @param world The world.
+ * @param cpus The CPU ids to pin workers to.
+ * @param cpu_count The number of elements in cpus.
+ * @param cpus_per_worker The number of CPUs each worker can run on.
+ */
+FLECS_API
+void ecs_set_worker_affinity(
+    ecs_world_t *world,
+    const int32_t *cpus,
+    int32_t cpu_count,
+    int32_t cpus_per_worker);
+
 ////////////////////////////////////////////////////////////////////////////////
 //// Module
 ////////////////////////////////////////////////////////////////////////////////
@@ -12817,6 +12960,33 @@ typedef struct ecs_system_desc_t {
     /** If true, system will be ran on multiple threads */
     bool multi_threaded;
 
+    /** If true, a multi_threaded system splits its matched entities into
+     * chunks that idle worker threads can steal from busy ones, instead of
+     * giving each thread a fixed share of every table. Helps when the cost
+     * per entity or table is uneven. Only applies to systems with a callback
+     * (not a run action) whose query matches $this. */
+    bool work_stealing;
+
+    /** If true, a system that isn't multi_threaded may run on any worker 
+     * thread, at the same time as other concurrent systems. Access is derived
+     * from the system query, so ids that the system gets or sets outside of 
+     * its fields should be added as terms with an inout annotation, for 
+     * example [in] Position(). 
+     * 
+     * When the world has worker threads, a merge is inserted before a system
+     * that accesses the same components as an earlier concurrent system 
+     * since the last merge, and before a system that is not concurrent and
+     * follows a concurrent system. Between two merges, the systems that are
+     * not concurrent run first on the main thread while the workers wait, 
+     * after which all threads run the concurrent systems. So a concurrent 
+     * system only runs at the same time as its neighbours in the pipeline 
+     * that are concurrent and don't access the same components, and each 
+     * extra merge costs a sync point. The merges keep deferred commands in 
+     * pipeline order. Without worker threads the flag has no effect. 
+     * Concurrent systems have the same restrictions as multi_threaded 
+     * systems, for example they can't create entities with ecs_new. */
+    bool concurrent;
+
     /** If true, system will have access to the actual world. Cannot be true at the
      * same time as multi_threaded. */
     bool immediate;
@@ -12847,9 +13017,18 @@ typedef struct ecs_system_t {
     /** Is system multithreaded */
     bool multi_threaded;
 
+    /** Does system use work stealing, see ecs_system_desc_t::work_stealing */
+    bool work_stealing;
+
+    /** Can system run concurrently, see ecs_system_desc_t::concurrent */
+    bool concurrent;
+
     /** Is system ran in immediate mode */
     bool immediate;
 
+    /** Work stealing state (internal) */
+    struct ecs_system_steal_t *steal;
+
     /** Cached system name (for perf tracing) */
     const char *name;
 
@@ -32168,6 +32347,20 @@ struct query_builder_i : term_builder_i<Base> {
         return *this;
     }
 
+    /** Provide a sort key for the order_by component.
+     * Tables are sorted by radix sorting the keys, which is faster than the
+     * compare function for large tables. Keys must be in the same order as the
+     * compare function passed to order_by.
+     *
+     * @tparam T The component used to sort.
+     * @param key Function that returns the sort key for a component value.
+     */
+    template <typename T>
+    Base& order_by_key(uint64_t(*key)(flecs::entity_t, const T*)) {
+        desc_->order_by_key = reinterpret_cast<ecs_order_by_key_action_t>(key);
+        return *this;
+    }
+
     /** Group and sort matched tables.
      * Similar to ecs_query_order_by(), but instead of sorting individual entities, this
      * operation only sorts matched tables. This can be useful of a query needs to
@@ -33234,6 +33427,27 @@ public:
         return *this;
     }
 
+    /** Specify whether idle threads can steal work from this system.
+     * Only has an effect on multi threaded systems.
+     *
+     * @param value If true entities are split into chunks that threads steal.
+     */
+    Base& work_stealing(bool value = true) {
+        desc_->work_stealing = value;
+        return *this;
+    }
+
+    /** Specify whether system can run on a worker thread at the same time as
+     * other systems that don't access the same components. Only has an 
+     * effect on systems that are not multi threaded.
+     *
+     * @param value If true system can run concurrently with other systems.
+     */
+    Base& concurrent(bool value = true) {
+        desc_->concurrent = value;
+        return *this;
+    }
+
     /** Specify whether system should be ran in staged context.
      *
      * @param value If false system will always run staged.
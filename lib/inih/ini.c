@@ -324,4 +324,191 @@ int ini_parse_string_length(const char* string, size_t length,
     ctx.num_left = length;
     return ini_parse_stream((ini_reader)ini_reader_string, &ctx, handler,
                             user);
-}
\ No newline at end of file
+}
+/* Nonzero if c is one of the chars in set. Unlike strchr(), never matches
+   NUL, which can appear inside a buffer. */
+static int ini_view_is_any(const char* set, char c)
+{
+    return c && strchr(set, c) != NULL;
+}
+
+/* Return pointer to first non-whitespace char in [s, end). */
+static const char* ini_view_lskip(const char* s, const char* end)
+{
+    while (s < end && isspace((unsigned char)(*s)))
+        s++;
+    return s;
+}
+
+/* Return end of [s, end) with trailing whitespace excluded. */
+static const char* ini_view_rstrip(const char* s, const char* end)
+{
+    while (end > s && isspace((unsigned char)(*(end - 1))))
+        end--;
+    return end;
+}
+
+/* Same as ini_find_chars_or_comment(), but bounded by end instead of NUL.
+   Returns end if neither is found. */
+static const char* ini_view_find_chars_or_comment(const char* s,
+                                                  const char* end,
+                                                  const char* chars)
+{
+#if INI_ALLOW_INLINE_COMMENTS
+    int was_space = 0;
+    while (s < end && (!chars || !ini_view_is_any(chars, *s)) &&
+           !(was_space && ini_view_is_any(INI_INLINE_COMMENT_PREFIXES, *s))) {
+        was_space = isspace((unsigned char)(*s));
+        s++;
+    }
+#else
+    while (s < end && (!chars || !ini_view_is_any(chars, *s))) {
+        s++;
+    }
+#endif
+    return s;
+}
+
+static ini_view ini_view_make(const char* start, const char* end)
+{
+    ini_view view;
+    view.ptr = start;
+    view.len = (size_t)(end - start);
+    return view;
+}
+
+/* See documentation in header file. */
+int ini_parse_buffer(const char* buffer, size_t length,
+                     ini_view_handler handler, void* user)
+{
+    const char* buffer_end = buffer + length;
+    const char* line = buffer;
+    const char* line_end;
+    const char* next;
+    const char* start;
+    const char* end;
+    const char* value_end;
+    ini_view section = ini_view_make(buffer, buffer);
+    ini_view name;
+    ini_view value;
+#if INI_ALLOW_MULTILINE
+    ini_view prev_name = ini_view_make(buffer, buffer);
+#endif
+    int lineno = 0;
+    int error = 0;
+
+#undef HANDLER
+#if INI_HANDLER_LINENO
+#define HANDLER(u, s, n, v) handler(u, s, n, v, lineno)
+#else
+#define HANDLER(u, s, n, v) handler(u, s, n, v)
+#endif
+
+    /* Scan through buffer line by line */
+    while (line < buffer_end) {
+        line_end = (const char*)memchr(line, '\n', (size_t)(buffer_end - line));
+        if (line_end) {
+            next = line_end + 1;
+        }
+        else {
+            line_end = buffer_end;
+            next = buffer_end;
+        }
+
+        lineno++;
+
+        start = line;
+#if INI_ALLOW_BOM
+        if (lineno == 1 && line_end - start >= 3 &&
+                           (unsigned char)start[0] == 0xEF &&
+                           (unsigned char)start[1] == 0xBB &&
+                           (unsigned char)start[2] == 0xBF) {
+            start += 3;
+        }
+#endif
+        start = ini_view_lskip(start, line_end);
+        line_end = ini_view_rstrip(start, line_end);
+
+        if (start == line_end ||
+            ini_view_is_any(INI_START_COMMENT_PREFIXES, *start)) {
+            /* Blank line or start-of-line comment */
+        }
+#if INI_ALLOW_MULTILINE
+        else if (prev_name.len && start > line) {
+#if INI_ALLOW_INLINE_COMMENTS
+            end = ini_view_find_chars_or_comment(start, line_end, NULL);
+            end = ini_view_rstrip(start, end);
+#else
+            end = line_end;
+#endif
+            /* Non-blank line with leading whitespace, treat as continuation
+               of previous name's value (as per Python configparser). */
+            if (!HANDLER(user, section, prev_name, ini_view_make(start, end)) &&
+                    !error)
+                error = lineno;
+        }
+#endif
+        else if (*start == '[') {
+            /* A "[section]" line */
+            end = ini_view_find_chars_or_comment(start + 1, line_end, "]");
+            if (end < line_end && *end == ']') {
+                section = ini_view_make(start + 1, end);
+#if INI_ALLOW_MULTILINE
+                prev_name = ini_view_make(buffer, buffer);
+#endif
+#if INI_CALL_HANDLER_ON_NEW_SECTION
+                if (!HANDLER(user, section, ini_view_make(NULL, NULL),
+                             ini_view_make(NULL, NULL)) && !error)
+                    error = lineno;
+#endif
+            }
+            else if (!error) {
+                /* No ']' found on section line */
+                error = lineno;
+            }
+        }
+        else {
+            /* Not a comment, must be a name[=:]value pair */
+            end = ini_view_find_chars_or_comment(start, line_end, "=:");
+            if (end < line_end && (*end == '=' || *end == ':')) {
+                name = ini_view_make(start, ini_view_rstrip(start, end));
+#if INI_ALLOW_INLINE_COMMENTS
+                value_end = ini_view_find_chars_or_comment(end + 1, line_end,
+                                                           NULL);
+#else
+                value_end = line_end;
+#endif
+                start = ini_view_lskip(end + 1, value_end);
+                value = ini_view_make(start, ini_view_rstrip(start, value_end));
+
+#if INI_ALLOW_MULTILINE
+                prev_name = name;
+#endif
+                /* Valid name[=:]value pair found, call handler */
+                if (!HANDLER(user, section, name, value) && !error)
+                    error = lineno;
+            }
+            else {
+                /* No '=' or ':' found on name[=:]value line */
+#if INI_ALLOW_NO_VALUE
+                name = ini_view_make(start, ini_view_rstrip(start, end));
+                if (!HANDLER(user, section, name, ini_view_make(NULL, NULL)) &&
+                        !error)
+                    error = lineno;
+#else
+                if (!error)
+                    error = lineno;
+#endif
+            }
+        }
+
+#if INI_STOP_ON_FIRST_ERROR
+        if (error)
+            break;
+#endif
+
+        line = next;
+    }
+
+    return error;
+}
@@ -101,6 +101,35 @@ INI_API int ini_parse_string(const char* string, ini_handler handler, void* user
    already in memory, or interfacing with C++ std::string_view. */
 INI_API int ini_parse_string_length(const char* string, size_t length, ini_handler handler, void* user);
 
+/* Length-delimited view into the buffer given to ini_parse_buffer(). Not
+   NUL-terminated. */
+typedef struct {
+    const char* ptr;
+    size_t len;
+} ini_view;
+
+/* Typedef for prototype of view handler function. value.ptr is NULL if
+   INI_ALLOW_NO_VALUE is set and the name has no value. */
+#if INI_HANDLER_LINENO
+typedef int (*ini_view_handler)(void* user, ini_view section,
+                                ini_view name, ini_view value,
+                                int lineno);
+#else
+typedef int (*ini_view_handler)(void* user, ini_view section,
+                                ini_view name, ini_view value);
+#endif
+
+/* Same as ini_parse_string_length(), but parses the buffer in place instead
+   of copying each line, and calls handler with views into the buffer. The
+   views stay valid for as long as the buffer does. There is no line, section
+   or name length limit, so INI_MAX_LINE and INI_USE_STACK don't apply. Useful
+   for large files that are memory-mapped or already in memory. Continuation
+   lines of a multi-line value are passed with the same name view (equal
+   name.ptr) as the line that started the value, while a name that is repeated
+   on a line of its own gets a view of that line. */
+INI_API int ini_parse_buffer(const char* buffer, size_t length,
+                             ini_view_handler handler, void* user);
+
 /* Nonzero to allow multi-line value parsing, in the style of Python's
    configparser. If allowed, ini_parse() will call the handler with the same
    name for each subsequent line parsed. */
@@ -122,6 +122,42 @@
 //   NOTE: See https://randomascii.wordpress.com/2012/02/25/comparing-floating-point-numbers-2012-edition/
 //   for more information about units in the last place.
 //
+// BENCHMARKS
+//
+//   BENCHMARK() registers a microbenchmark the same way TEST() registers a
+//   test. Its body must contain exactly one BENCHMARK_LOOP, which is the timed
+//   part. Anything before and after the loop is untimed setup and cleanup.
+//
+//      BENCHMARK(config, lookup) {
+//          Config* config = config_load("setup.cfg", "setup.cfg.bin");
+//          BENCHMARK_LOOP {
+//              config_int(config, "window", "width", 0);
+//          }
+//          config_free(config);
+//      }
+//
+//   Benchmarks only run when passing --rktest_bench, which in turn skips the
+//   regular tests. The number of loop iterations is calibrated so that each
+//   sample takes at least --rktest_bench_min_time milliseconds. The body is
+//   then run once per sample and the time per iteration is reported as
+//   min/median/p99/stddev plus operations per second, measured with a
+//   monotonic nanosecond clock. Assertions work in benchmarks as in tests.
+//
+//   To catch regressions, save the results of a known good build with
+//   --rktest_bench_out=FILE and pass that file to later runs with
+//   --rktest_bench_baseline=FILE. Each benchmark's samples are compared to the
+//   baseline's samples with a one-sided Mann-Whitney U test. A benchmark fails
+//   if it is slower with p < 0.01 and its median grew by more than
+//   --rktest_bench_threshold percent, so the run exits non-zero.
+//
+//   On Linux, --rktest_bench_counters also reads the CPU's performance counters
+//   through perf_event_open while BENCHMARK_LOOP runs, and reports cycles,
+//   instructions, IPC, cache misses and branch misses per iteration. These tell
+//   a regression caused by extra work apart from one caused by cache behaviour.
+//   Only user space is counted, so it works with perf_event_paranoid up to 2.
+//   The counts include threads started while the benchmarks run, so work done
+//   by a benchmark's worker threads is part of its numbers.
+//
 // OPTIONS
 //
 //   The unit test binary built with RK Test can take command line arguments:
@@ -141,9 +177,41 @@
 //
 //      --rktest_print_filenames=0
 //        Disable printing out the filename of a test case on assert failure.
+//
+//      --rktest_jobs=N
+//        Run up to N tests at the same time, each in its own process, so a test
+//        that crashes only fails itself. Output is still printed in test order.
+//        Suite times are then the sum of their test times. Only available on
+//        platforms with fork(), elsewhere tests run serially.
+//
+//      --rktest_bench
+//        Run the benchmarks instead of the tests. Always runs serially.
+//
+//      --rktest_bench_samples=N
+//        Number of timed samples per benchmark. The default is 30.
+//
+//      --rktest_bench_min_time=MS
+//        Minimum duration of one sample in milliseconds. The default is 10.
+//
+//      --rktest_bench_out=FILE
+//        Write benchmark results as CSV to FILE, one row per benchmark with the
+//        statistics in nanoseconds per iteration followed by every sample.
+//
+//      --rktest_bench_baseline=FILE
+//        Compare benchmark results against a file written by --rktest_bench_out
+//        and fail benchmarks that regressed significantly.
+//
+//      --rktest_bench_threshold=PERCENT
+//        Median slowdown below which a regression is treated as noise. The
+//        default is 5.
+//
+//      --rktest_bench_counters
+//        Report hardware performance counters per benchmark iteration. Only
+//        available on Linux.
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -165,6 +233,25 @@ int rktest_main(int argc, const char* argv[]);
 	ADD_TO_MEMORY_SECTION_END                                                          \
 	void SUITE##_##NAME##_impl(void)
 
+#define BENCHMARK(SUITE, NAME)                                                         \
+	void SUITE##_##NAME##_impl(void);                                                  \
+	const rktest_test_t SUITE##_##NAME##_data = {                                      \
+		.suite_name = #SUITE,                                                          \
+		.test_name = #NAME,                                                            \
+		.run = &SUITE##_##NAME##_impl,                                                 \
+		.is_benchmark = true                                                           \
+	};                                                                                 \
+	ADD_TO_MEMORY_SECTION_BEGIN                                                        \
+	const rktest_test_t* const SUITE##_##NAME##_data##_##ptr = &SUITE##_##NAME##_data; \
+	ADD_TO_MEMORY_SECTION_END                                                          \
+	void SUITE##_##NAME##_impl(void)
+
+// Runs the statement or block following it for the calibrated number of
+// iterations, timing all of them together
+#define BENCHMARK_LOOP                                            \
+	for (size_t rktest_bench_left = rktest_bench_loop_start();    \
+		 rktest_bench_left > 0 ? (rktest_bench_left--, true) : !rktest_bench_loop_stop();)
+
 #define TEST_SETUP(SUITE)                                                            \
 	void SUITE##_##setup(void);                                                      \
 	const rktest_test_t SUITE##_##setup##_data = {                                   \
@@ -335,6 +422,7 @@ typedef struct {
 	void (*setup)(void);
 	void (*teardown)(void);
 	bool is_disabled;
+	bool is_benchmark;
 } rktest_test_t;
 
 /* Assertions */
@@ -345,6 +433,9 @@ typedef struct {
 #define RKTEST_MATCH_CASE true
 
 void rktest_fail_current_test(void);
+size_t rktest_bench_loop_start(void);
+bool rktest_bench_loop_stop(void);
+uint64_t rktest_now_ns(void);
 bool rktest_string_is_number(const char* str);
 int rktest_strcasecmp(const char* lhs, const char* rhs);
 bool rktest_floats_within_4_ulp(float lhs, float rhs);
@@ -567,6 +658,22 @@ bool rktest_filenames_enabled(void);
 #include <time.h>
 #endif
 
+#ifdef __linux__
+#define RKTEST_HAS_PERF_COUNTERS
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RKTEST_HAS_FORK
+#include <errno.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #ifdef __GNUC__
 #pragma GCC diagnostic ignored "-Wmissing-braces"
 #endif
@@ -670,7 +777,7 @@ rktest_timer_t rktest_timer_start(void) {
 #else
 rktest_timer_t rktest_timer_start(void) {
 	rktest_timer_t timer;
-	clock_gettime(CLOCK_REALTIME, &timer.start);
+	clock_gettime(CLOCK_MONOTONIC, &timer.start);
 	return timer;
 }
 #endif
@@ -690,16 +797,44 @@ rktest_millis_t rktest_timer_stop(rktest_timer_t* timer) {
 }
 #else
 rktest_millis_t rktest_timer_stop(rktest_timer_t* timer) {
-	clock_gettime(CLOCK_REALTIME, &timer->end);
-	rktest_millis_t ms = 0;
-	ms += (rktest_millis_t)((timer->end.tv_sec - timer->start.tv_sec) * 1000.0); // seconds
-	ms += (rktest_millis_t)((timer->end.tv_nsec - timer->start.tv_nsec) / 1000.0); // milliseconds
-	return ms;
+	clock_gettime(CLOCK_MONOTONIC, &timer->end);
+	const int64_t ns = (int64_t)(timer->end.tv_sec - timer->start.tv_sec) * 1000000000 + (timer->end.tv_nsec - timer->start.tv_nsec);
+	return (rktest_millis_t)(ns / 1000000);
+}
+#endif
+
+#if defined(WIN32)
+uint64_t rktest_now_ns(void) {
+	static double ns_per_tick = 0.0;
+	LARGE_INTEGER li;
+	if (ns_per_tick == 0.0) {
+		QueryPerformanceFrequency(&li);
+		ns_per_tick = 1e9 / (double)li.QuadPart;
+	}
+	QueryPerformanceCounter(&li);
+	return (uint64_t)((double)li.QuadPart * ns_per_tick);
+}
+#elif defined(__MACH__)
+uint64_t rktest_now_ns(void) {
+	static mach_timebase_info_data_t timebase_info;
+	if (timebase_info.denom == 0) {
+		mach_timebase_info(&timebase_info);
+	}
+	return mach_absolute_time() * timebase_info.numer / timebase_info.denom;
+}
+#else
+uint64_t rktest_now_ns(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
 }
 #endif
 
 /* -------------------------- Types and constants -------------------------- */
 #define RKTEST_MAX_FILTER_LENGTH 256
+#define RKTEST_MAX_PATH_LENGTH 256
+#define RKTEST_MAX_BENCH_ITERATIONS 1000000000
+#define RKTEST_BENCH_ALPHA 0.01
 
 typedef enum {
 	RKTEST_ENABLE_VTERM_ERROR_INVALID_HANDLE_VALUE,
@@ -718,8 +853,38 @@ typedef struct {
 	rktest_color_mode_t color_mode;
 	char test_filter[RKTEST_MAX_FILTER_LENGTH];
 	bool print_timestamps_enabled;
+	size_t num_jobs;
+	bool run_benchmarks;
+	size_t bench_samples;
+	rktest_millis_t bench_min_time_ms;
+	char bench_output[RKTEST_MAX_PATH_LENGTH];
+	char bench_baseline[RKTEST_MAX_PATH_LENGTH];
+	double bench_threshold_percent;
+	bool bench_counters;
 } rktest_config_t;
 
+typedef enum {
+	RKTEST_COUNTER_CYCLES,
+	RKTEST_COUNTER_INSTRUCTIONS,
+	RKTEST_COUNTER_CACHE_MISSES,
+	RKTEST_COUNTER_BRANCH_MISSES,
+	RKTEST_NUM_COUNTERS,
+} rktest_counter_t;
+
+typedef struct {
+	const char* suite_name;
+	const char* test_name;
+	size_t iterations;
+	vec_t(double) samples; // Nanoseconds per iteration, sorted
+	double min_ns;
+	double median_ns;
+	double p99_ns;
+	double mean_ns;
+	double stddev_ns;
+	double ops_per_sec;
+	double counters[RKTEST_NUM_COUNTERS]; // Per iteration, negative if not measured
+} rktest_bench_result_t;
+
 typedef struct {
 	const char* name;
 	vec_t(rktest_test_t) tests;
@@ -804,6 +969,24 @@ static bool g_colors_enabled = false;
 static bool g_current_test_failed = false;
 static bool g_filenames_enabled = true;
 
+/* Benchmark loop state, see BENCHMARK_LOOP */
+static size_t g_bench_iterations = 0;
+static size_t g_bench_num_loops = 0;
+static uint64_t g_bench_start_ns = 0;
+static uint64_t g_bench_elapsed_ns = 0;
+static vec_t(rktest_bench_result_t) g_bench_results = NULL;
+static vec_t(rktest_bench_result_t) g_bench_baseline = NULL;
+static char* g_bench_baseline_data = NULL; // Strings of g_bench_baseline point into this
+
+/* Hardware counters, one perf event group led by the first open counter */
+static int g_counter_fds[RKTEST_NUM_COUNTERS] = { -1, -1, -1, -1 };
+static int g_counter_group_fd = -1;
+static uint64_t g_counter_totals[RKTEST_NUM_COUNTERS];
+static uint64_t g_counter_starts[RKTEST_NUM_COUNTERS][3]; // Reads at the start of BENCHMARK_LOOP
+
+static void rktest_counters_begin(void);
+static void rktest_counters_end(void);
+
 bool rktest_colors_enabled(void) {
 	return g_colors_enabled;
 }
@@ -816,6 +999,19 @@ void rktest_fail_current_test(void) {
 	g_current_test_failed = true;
 }
 
+size_t rktest_bench_loop_start(void) {
+	g_bench_num_loops++;
+	rktest_counters_begin();
+	g_bench_start_ns = rktest_now_ns();
+	return g_bench_iterations;
+}
+
+bool rktest_bench_loop_stop(void) {
+	g_bench_elapsed_ns += rktest_now_ns() - g_bench_start_ns;
+	rktest_counters_end();
+	return true;
+}
+
 bool rktest_string_is_number(const char* str) {
 	for (int i = 0; str[i] != '\0'; i++) {
 		if (!isdigit(str[i])) {
@@ -889,12 +1085,61 @@ static void print_usage(void) {
 	printf("\n");
 	printf("  --rktest_print_filenames=0\n");
 	printf("    Disable printing out the filename of a test case on assert failure.\n");
+	printf("\n");
+	printf("  --rktest_jobs=N\n");
+	printf("    Run up to N tests at the same time, each in its own process.\n");
+	printf("\n");
+	printf("  --rktest_bench\n");
+	printf("    Run the benchmarks instead of the tests.\n");
+	printf("\n");
+	printf("  --rktest_bench_samples=N\n");
+	printf("    Number of timed samples per benchmark. The default is 30.\n");
+	printf("\n");
+	printf("  --rktest_bench_min_time=MS\n");
+	printf("    Minimum duration of one sample in milliseconds. The default is 10.\n");
+	printf("\n");
+	printf("  --rktest_bench_out=FILE\n");
+	printf("    Write benchmark results as CSV to FILE.\n");
+	printf("\n");
+	printf("  --rktest_bench_baseline=FILE\n");
+	printf("    Fail benchmarks that are significantly slower than in FILE.\n");
+	printf("\n");
+	printf("  --rktest_bench_threshold=PERCENT\n");
+	printf("    Median slowdown tolerated as noise. The default is 5.\n");
+	printf("\n");
+	printf("  --rktest_bench_counters\n");
+	printf("    Report hardware performance counters per iteration (Linux only).\n");
+}
+
+static void copy_path_arg(char* dest, const char* arg, const char* prefix) {
+	const char* path = arg + strlen(prefix);
+	if (strlen(path) > RKTEST_MAX_PATH_LENGTH - 1) {
+		fprintf(stderr, "Error: path too long. Max length is (%d)\n", RKTEST_MAX_PATH_LENGTH - 1);
+		exit(1);
+	}
+	strncpy(dest, path, RKTEST_MAX_PATH_LENGTH - 1);
+}
+
+static long parse_positive_arg(const char* arg, const char* prefix) {
+	const char* value_str = arg + strlen(prefix);
+	char* end = NULL;
+	const long value = strtol(value_str, &end, 10);
+	if (*value_str == '\0' || *end != '\0' || value < 1) {
+		fprintf(stderr, "Error: Invalid value in %s\n", arg);
+		print_usage();
+		exit(1);
+	}
+	return value;
 }
 
 static rktest_config_t parse_args(int argc, const char* argv[]) {
 	rktest_config_t config = (rktest_config_t) { 0 };
 	config.color_mode = RKTEST_COLOR_MODE_AUTO;
 	config.print_timestamps_enabled = true;
+	config.num_jobs = 1;
+	config.bench_samples = 30;
+	config.bench_min_time_ms = 10;
+	config.bench_threshold_percent = 5.0;
 
 	for (int i = 1; i < argc; i++) {
 		const char* arg = argv[i];
@@ -944,6 +1189,45 @@ static rktest_config_t parse_args(int argc, const char* argv[]) {
 			}
 		}
 
+		else if (string_starts_with(arg, "--rktest_jobs=")) {
+			config.num_jobs = (size_t)parse_positive_arg(arg, "--rktest_jobs=");
+		}
+
+		else if (strcmp(arg, "--rktest_bench") == 0) {
+			config.run_benchmarks = true;
+		}
+
+		else if (string_starts_with(arg, "--rktest_bench_samples=")) {
+			config.bench_samples = (size_t)parse_positive_arg(arg, "--rktest_bench_samples=");
+		}
+
+		else if (string_starts_with(arg, "--rktest_bench_min_time=")) {
+			config.bench_min_time_ms = (rktest_millis_t)parse_positive_arg(arg, "--rktest_bench_min_time=");
+		}
+
+		else if (string_starts_with(arg, "--rktest_bench_out=")) {
+			copy_path_arg(config.bench_output, arg, "--rktest_bench_out=");
+		}
+
+		else if (string_starts_with(arg, "--rktest_bench_baseline=")) {
+			copy_path_arg(config.bench_baseline, arg, "--rktest_bench_baseline=");
+		}
+
+		else if (strcmp(arg, "--rktest_bench_counters") == 0) {
+			config.bench_counters = true;
+		}
+
+		else if (string_starts_with(arg, "--rktest_bench_threshold=")) {
+			const char* value_str = arg + strlen("--rktest_bench_threshold=");
+			char* end = NULL;
+			config.bench_threshold_percent = strtod(value_str, &end);
+			if (*value_str == '\0' || *end != '\0' || config.bench_threshold_percent < 0.0) {
+				fprintf(stderr, "Error: Invalid value in %s\n", arg);
+				print_usage();
+				exit(1);
+			}
+		}
+
 		else {
 			fprintf(stderr, "Error: Unrecognized argument %s\n", arg);
 			print_usage();
@@ -1055,7 +1339,7 @@ static rktest_environment_t setup_test_env(const rktest_config_t* config) {
 			suite->teardown = test.teardown;
 		}
 		/* Else: Add test to suite */
-		else if (test_matches_filter(&test, config->test_filter)) {
+		else if (test.is_benchmark == config->run_benchmarks && test_matches_filter(&test, config->test_filter)) {
 			if (string_starts_with(test.test_name, "DISABLED_")) {
 				test.is_disabled = true;
 				suite->num_disabled_tests++;
@@ -1089,6 +1373,430 @@ static rktest_environment_t setup_test_env(const rktest_config_t* config) {
 	return env;
 }
 
+static int compare_doubles(const void* lhs, const void* rhs) {
+	const double a = *(const double*)lhs;
+	const double b = *(const double*)rhs;
+	return (a > b) - (a < b);
+}
+
+#ifdef RKTEST_HAS_PERF_COUNTERS
+static int open_counter(uint32_t type, uint64_t config) {
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.disabled = g_counter_group_fd == -1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	/* Also count the threads a benchmark starts, such as worker threads. The
+	   kernel can't read inherited counters as a group, so each is read alone. */
+	attr.inherit = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	return (int)syscall(SYS_perf_event_open, &attr, 0, -1, g_counter_group_fd, 0);
+}
+
+// Opens the counters the CPU supports. Returns false if none could be opened.
+static bool open_counters(void) {
+	static const uint64_t configs[RKTEST_NUM_COUNTERS] = {
+		[RKTEST_COUNTER_CYCLES] = PERF_COUNT_HW_CPU_CYCLES,
+		[RKTEST_COUNTER_INSTRUCTIONS] = PERF_COUNT_HW_INSTRUCTIONS,
+		[RKTEST_COUNTER_CACHE_MISSES] = PERF_COUNT_HW_CACHE_MISSES,
+		[RKTEST_COUNTER_BRANCH_MISSES] = PERF_COUNT_HW_BRANCH_MISSES,
+	};
+
+	for (size_t i = 0; i < RKTEST_NUM_COUNTERS; i++) {
+		g_counter_fds[i] = open_counter(PERF_TYPE_HARDWARE, configs[i]);
+		if (g_counter_group_fd == -1) {
+			g_counter_group_fd = g_counter_fds[i];
+		}
+	}
+	return g_counter_group_fd != -1;
+}
+
+static void close_counters(void) {
+	for (size_t i = 0; i < RKTEST_NUM_COUNTERS; i++) {
+		if (g_counter_fds[i] != -1) {
+			close(g_counter_fds[i]);
+			g_counter_fds[i] = -1;
+		}
+	}
+	g_counter_group_fd = -1;
+}
+
+/* Reads { value, time_enabled, time_running }, summed over all counted threads.
+   Threads that exited keep adding to it, and a reset doesn't clear their part,
+   so counts are taken as the difference between two reads. */
+static bool read_counter(size_t index, uint64_t data[3]) {
+	return g_counter_fds[index] != -1 &&
+		read(g_counter_fds[index], data, 3 * sizeof(uint64_t)) == (ssize_t)(3 * sizeof(uint64_t));
+}
+
+static void rktest_counters_begin(void) {
+	if (g_counter_group_fd == -1) {
+		return;
+	}
+
+	for (size_t i = 0; i < RKTEST_NUM_COUNTERS; i++) {
+		if (!read_counter(i, g_counter_starts[i])) {
+			memset(g_counter_starts[i], 0, sizeof(g_counter_starts[i]));
+		}
+	}
+	ioctl(g_counter_group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+static void rktest_counters_end(void) {
+	if (g_counter_group_fd == -1) {
+		return;
+	}
+	ioctl(g_counter_group_fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+	for (size_t i = 0; i < RKTEST_NUM_COUNTERS; i++) {
+		uint64_t data[3];
+		if (!read_counter(i, data)) {
+			continue;
+		}
+
+		const uint64_t value = data[0] - g_counter_starts[i][0];
+		const uint64_t enabled = data[1] - g_counter_starts[i][1];
+		const uint64_t running = data[2] - g_counter_starts[i][2];
+
+		/* Scale up if the kernel had to multiplex the counters with other events */
+		const double scale = running > 0 && running < enabled ? (double)enabled / (double)running : 1.0;
+		g_counter_totals[i] += (uint64_t)((double)value * scale);
+	}
+}
+#else
+static bool open_counters(void) {
+	return false;
+}
+
+static void close_counters(void) {
+}
+
+static void rktest_counters_begin(void) {
+}
+
+static void rktest_counters_end(void) {
+}
+#endif
+
+// Runs the benchmark body once with the given number of loop iterations and
+// returns the time spent inside BENCHMARK_LOOP.
+static bool run_benchmark_sample(const rktest_test_t* test, size_t iterations, uint64_t* elapsed_ns) {
+	g_bench_iterations = iterations;
+	g_bench_num_loops = 0;
+	g_bench_elapsed_ns = 0;
+
+	test->run();
+
+	if (g_bench_num_loops != 1) {
+		rktest_log_error("error: ", "Benchmark body ran BENCHMARK_LOOP %zu times, expected exactly once\n", g_bench_num_loops);
+		rktest_fail_current_test();
+		return false;
+	}
+
+	*elapsed_ns = g_bench_elapsed_ns;
+	return !g_current_test_failed;
+}
+
+static void format_duration(char* str, size_t size, double ns) {
+	if (ns < 1e3) {
+		snprintf(str, size, "%.2f ns", ns);
+	} else if (ns < 1e6) {
+		snprintf(str, size, "%.2f us", ns / 1e3);
+	} else if (ns < 1e9) {
+		snprintf(str, size, "%.2f ms", ns / 1e6);
+	} else {
+		snprintf(str, size, "%.2f s", ns / 1e9);
+	}
+}
+
+static void format_rate(char* str, size_t size, double per_sec) {
+	if (per_sec < 1e3) {
+		snprintf(str, size, "%.2f", per_sec);
+	} else if (per_sec < 1e6) {
+		snprintf(str, size, "%.2fk", per_sec / 1e3);
+	} else if (per_sec < 1e9) {
+		snprintf(str, size, "%.2fM", per_sec / 1e6);
+	} else {
+		snprintf(str, size, "%.2fG", per_sec / 1e9);
+	}
+}
+
+static void print_bench_result(const rktest_bench_result_t* result) {
+	char median[32], min[32], p99[32], stddev[32], ops[32];
+	format_duration(median, sizeof(median), result->median_ns);
+	format_duration(min, sizeof(min), result->min_ns);
+	format_duration(p99, sizeof(p99), result->p99_ns);
+	format_duration(stddev, sizeof(stddev), result->stddev_ns);
+	format_rate(ops, sizeof(ops), result->ops_per_sec);
+
+	rktest_printf_green("[  BENCH   ] ");
+	printf("median %s, min %s, p99 %s, stddev %s, %s ops/s (%zu samples x %zu iterations)\n",
+		median, min, p99, stddev, ops, vec_len(result->samples), result->iterations);
+
+	static const char* const counter_names[RKTEST_NUM_COUNTERS] = {
+		"cycles", "instructions", "cache misses", "branch misses"
+	};
+	bool has_counters = false;
+	for (size_t i = 0; i < RKTEST_NUM_COUNTERS; i++) {
+		if (result->counters[i] < 0.0) {
+			continue;
+		}
+		char count[32];
+		format_rate(count, sizeof(count), result->counters[i]);
+		if (!has_counters) {
+			rktest_printf_green("[ COUNTERS ] ");
+		}
+		printf("%s%s %s", has_counters ? ", " : "", count, counter_names[i]);
+		has_counters = true;
+	}
+	if (has_counters) {
+		if (result->counters[RKTEST_COUNTER_CYCLES] > 0.0 && result->counters[RKTEST_COUNTER_INSTRUCTIONS] >= 0.0) {
+			printf(", %.2f IPC", result->counters[RKTEST_COUNTER_INSTRUCTIONS] / result->counters[RKTEST_COUNTER_CYCLES]);
+		}
+		printf(" per iteration\n");
+	}
+}
+
+// One-sided Mann-Whitney U test. Returns the p-value of the samples in `a`
+// being no larger than those in `b`, using the normal approximation with tie
+// and continuity correction. Both inputs must be sorted.
+static double mann_whitney_p_greater(const double* a, size_t n1, const double* b, size_t n2) {
+	const size_t n = n1 + n2;
+	double rank_sum_a = 0.0;
+	double tie_term = 0.0;
+
+	/* Walk both sorted arrays as one, giving ties their average rank */
+	size_t i = 0, j = 0;
+	while (i < n1 || j < n2) {
+		const double value = (j >= n2 || (i < n1 && a[i] <= b[j])) ? a[i] : b[j];
+		size_t count_a = 0, count_b = 0;
+		while (i < n1 && a[i] == value) {
+			i++;
+			count_a++;
+		}
+		while (j < n2 && b[j] == value) {
+			j++;
+			count_b++;
+		}
+		const double count = (double)(count_a + count_b);
+		const double first_rank = (double)(i + j) - count + 1.0;
+		rank_sum_a += (double)count_a * (first_rank + (count - 1.0) / 2.0);
+		tie_term += count * count * count - count;
+	}
+
+	const double u = rank_sum_a - (double)n1 * (double)(n1 + 1) / 2.0;
+	const double mean = (double)n1 * (double)n2 / 2.0;
+	const double variance = (double)n1 * (double)n2 / 12.0 * ((double)(n + 1) - tie_term / ((double)n * (double)(n - 1)));
+	if (variance <= 0.0) {
+		return 1.0;
+	}
+
+	const double z = (u - mean - 0.5) / sqrt(variance);
+	return 0.5 * erfc(z / sqrt(2.0));
+}
+
+static const rktest_bench_result_t* find_baseline(const char* suite_name, const char* test_name) {
+	vec_foreach(const rktest_bench_result_t*, baseline, g_bench_baseline) {
+		if (strcmp(baseline->suite_name, suite_name) == 0 && strcmp(baseline->test_name, test_name) == 0) {
+			return baseline;
+		}
+	}
+	return NULL;
+}
+
+static void compare_with_baseline(const rktest_bench_result_t* result, const rktest_config_t* config) {
+	const rktest_bench_result_t* baseline = find_baseline(result->suite_name, result->test_name);
+	if (!baseline) {
+		rktest_log_warning("[ BASELINE ] ", "not in baseline\n");
+		return;
+	}
+
+	const double change_percent = (result->median_ns / baseline->median_ns - 1.0) * 100.0;
+	const double p = mann_whitney_p_greater(result->samples, vec_len(result->samples), baseline->samples, vec_len(baseline->samples));
+
+	if (p < RKTEST_BENCH_ALPHA && change_percent > config->bench_threshold_percent) {
+		rktest_log_error("[ BASELINE ] ", "%+.1f%% median, p = %.4f: regression\n", change_percent, p);
+		rktest_fail_current_test();
+	} else {
+		rktest_log_info("[ BASELINE ] ", "%+.1f%% median, p = %.4f\n", change_percent, p);
+	}
+}
+
+// Parses a file written by write_bench_results()
+static bool load_bench_baseline(const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (!file) {
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	g_bench_baseline_data = malloc(size > 0 ? (size_t)size + 1 : 1);
+	const bool read_ok = size >= 0 && fread(g_bench_baseline_data, 1, (size_t)size, file) == (size_t)size;
+	fclose(file);
+	if (!read_ok) {
+		return false;
+	}
+	g_bench_baseline_data[size] = '\0';
+
+	/* Skip header line */
+	char* line = strchr(g_bench_baseline_data, '\n');
+	while (line && *++line) {
+		char* line_end = strchr(line, '\n');
+		if (line_end) {
+			*line_end = '\0';
+		}
+
+		/* The samples are always the last column */
+		char* fields[16] = { 0 };
+		size_t num_fields = 0;
+		for (char* it = line; num_fields < 16; it++) {
+			fields[num_fields++] = it;
+			it = strchr(it, ',');
+			if (!it) {
+				break;
+			}
+			*it = '\0';
+		}
+
+		if (num_fields >= 11) {
+			rktest_bench_result_t baseline = { 0 };
+			baseline.suite_name = fields[0];
+			baseline.test_name = fields[1];
+			baseline.iterations = (size_t)strtoull(fields[2], NULL, 10);
+			baseline.median_ns = strtod(fields[5], NULL);
+			char* it = fields[num_fields - 1];
+			char* end = NULL;
+			for (double sample = strtod(it, &end); end != it; sample = strtod(it, &end)) {
+				vec_push(baseline.samples, sample);
+				it = end;
+			}
+			qsort(baseline.samples, vec_len(baseline.samples), sizeof(double), compare_doubles);
+			if (vec_len(baseline.samples) > 0) {
+				vec_push(g_bench_baseline, baseline);
+			}
+		}
+
+		line = line_end;
+	}
+
+	return true;
+}
+
+// Calibrates the iteration count, collects the samples and records the result
+static void run_benchmark(const rktest_test_t* test, const rktest_config_t* config) {
+	const uint64_t min_time_ns = (uint64_t)config->bench_min_time_ms * 1000000;
+	size_t iterations = 1;
+	uint64_t elapsed_ns = 0;
+
+	/* Grow the iteration count until one sample is long enough to time */
+	while (true) {
+		if (!run_benchmark_sample(test, iterations, &elapsed_ns)) {
+			return;
+		}
+		if (elapsed_ns >= min_time_ns || iterations >= RKTEST_MAX_BENCH_ITERATIONS) {
+			break;
+		}
+
+		double scale = elapsed_ns > 0 ? 1.4 * (double)min_time_ns / (double)elapsed_ns : 100.0;
+		scale = scale < 2.0 ? 2.0 : (scale > 100.0 ? 100.0 : scale);
+		const double next = (double)iterations * scale;
+		iterations = next > RKTEST_MAX_BENCH_ITERATIONS ? RKTEST_MAX_BENCH_ITERATIONS : (size_t)next;
+	}
+
+	rktest_bench_result_t result = { 0 };
+	result.suite_name = test->suite_name;
+	result.test_name = test->test_name;
+	result.iterations = iterations;
+
+	memset(g_counter_totals, 0, sizeof(g_counter_totals));
+	for (size_t i = 0; i < config->bench_samples; i++) {
+		if (!run_benchmark_sample(test, iterations, &elapsed_ns)) {
+			vec_free(result.samples);
+			return;
+		}
+		vec_push(result.samples, (double)elapsed_ns / (double)iterations);
+	}
+
+	/* Statistics over the time per iteration */
+	const size_t n = vec_len(result.samples);
+	qsort(result.samples, n, sizeof(double), compare_doubles);
+
+	double sum = 0.0;
+	vec_foreach(const double*, sample, result.samples) {
+		sum += *sample;
+	}
+
+	result.min_ns = result.samples[0];
+	result.median_ns = n % 2 ? result.samples[n / 2] : (result.samples[n / 2 - 1] + result.samples[n / 2]) / 2.0;
+	result.p99_ns = result.samples[(size_t)ceil(0.99 * (double)n) - 1];
+	result.mean_ns = sum / (double)n;
+
+	double sum_sq = 0.0;
+	vec_foreach(const double*, sample, result.samples) {
+		sum_sq += (*sample - result.mean_ns) * (*sample - result.mean_ns);
+	}
+	result.stddev_ns = n > 1 ? sqrt(sum_sq / (double)(n - 1)) : 0.0;
+	result.ops_per_sec = result.median_ns > 0.0 ? 1e9 / result.median_ns : 0.0;
+
+	const double total_iterations = (double)iterations * (double)n;
+	for (size_t i = 0; i < RKTEST_NUM_COUNTERS; i++) {
+		result.counters[i] = g_counter_fds[i] != -1 ? (double)g_counter_totals[i] / total_iterations : -1.0;
+	}
+
+	print_bench_result(&result);
+	if (*config->bench_baseline) {
+		compare_with_baseline(&result, config);
+	}
+	vec_push(g_bench_results, result);
+}
+
+static bool write_bench_results(const char* path) {
+	FILE* file = fopen(path, "w");
+	if (!file) {
+		return false;
+	}
+
+	fprintf(file, "suite,name,iterations,samples,min_ns,median_ns,p99_ns,mean_ns,stddev_ns,ops_per_sec,"
+				  "cycles,instructions,cache_misses,branch_misses,sample_ns\n");
+	vec_foreach(const rktest_bench_result_t*, result, g_bench_results) {
+		fprintf(file, "%s,%s,%zu,%zu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,",
+			result->suite_name, result->test_name, result->iterations, vec_len(result->samples),
+			result->min_ns, result->median_ns, result->p99_ns, result->mean_ns, result->stddev_ns, result->ops_per_sec);
+		/* Counters per iteration, empty if not measured */
+		for (size_t i = 0; i < RKTEST_NUM_COUNTERS; i++) {
+			if (result->counters[i] >= 0.0) {
+				fprintf(file, "%.3f", result->counters[i]);
+			}
+			fprintf(file, ",");
+		}
+		for (size_t i = 0; i < vec_len(result->samples); i++) {
+			fprintf(file, "%s%.3f", i ? " " : "", result->samples[i]);
+		}
+		fprintf(file, "\n");
+	}
+
+	return fclose(file) == 0;
+}
+
+static void free_bench_results(void) {
+	vec_foreach(rktest_bench_result_t*, result, g_bench_results) {
+		vec_free(result->samples);
+	}
+	vec_free(g_bench_results);
+
+	vec_foreach(rktest_bench_result_t*, baseline, g_bench_baseline) {
+		vec_free(baseline->samples);
+	}
+	vec_free(g_bench_baseline);
+	free(g_bench_baseline_data);
+	g_bench_baseline_data = NULL;
+}
+
 static bool run_test(const rktest_test_t* test, const rktest_config_t* config) {
 	rktest_log_info("[ RUN      ] ", "%s.%s \n", test->suite_name, test->test_name);
 
@@ -1099,7 +1807,11 @@ static bool run_test(const rktest_test_t* test, const rktest_config_t* config) {
 
 	/* Run test */
 	rktest_timer_t test_timer = rktest_timer_start();
-	test->run();
+	if (test->is_benchmark) {
+		run_benchmark(test, config);
+	} else {
+		test->run();
+	}
 	rktest_millis_t test_time_ms = rktest_timer_stop(&test_timer);
 
 	/* Run teardown if exists*/
@@ -1163,6 +1875,219 @@ static rktest_report_t run_all_tests(rktest_environment_t* env, const rktest_con
 	return report;
 }
 
+#ifdef RKTEST_HAS_FORK
+// A test running (or waiting to run) in a child process
+typedef struct {
+	const rktest_test_t* test;
+	pid_t pid;
+	int output_fd; // Read end of the child's stdout and stderr
+	vec_t(char) output;
+	rktest_timer_t timer;
+	rktest_millis_t time_ms;
+	int status;
+	bool is_started;
+	bool is_done;
+} rktest_job_t;
+
+static bool start_job(rktest_job_t* job, const rktest_config_t* config) {
+	int fds[2];
+	if (pipe(fds) != 0) {
+		return false;
+	}
+
+	/* Don't let the child inherit and print unflushed parent output */
+	fflush(stdout);
+	fflush(stderr);
+
+	job->timer = rktest_timer_start();
+	job->pid = fork();
+	if (job->pid < 0) {
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+
+	if (job->pid == 0) {
+		close(fds[0]);
+		dup2(fds[1], STDOUT_FILENO);
+		dup2(fds[1], STDERR_FILENO);
+		close(fds[1]);
+
+		/* Keep what was printed before a crash */
+		setvbuf(stdout, NULL, _IOLBF, 0);
+
+		const bool test_passed = run_test(job->test, config);
+		fflush(stdout);
+		fflush(stderr);
+		_exit(test_passed ? 0 : 1);
+	}
+
+	close(fds[1]);
+	job->output_fd = fds[0];
+	job->is_started = true;
+	return true;
+}
+
+// Reads what the job has written. Returns false once the job has exited.
+static bool read_job_output(rktest_job_t* job) {
+	char buffer[4096];
+	const ssize_t num_read = read(job->output_fd, buffer, sizeof(buffer));
+	if (num_read < 0 && errno == EINTR) {
+		return true;
+	}
+
+	if (num_read > 0) {
+		vec_maybegrow(job->output, (size_t)num_read);
+		memcpy(&job->output[vec_len(job->output)], buffer, (size_t)num_read);
+		vec_header(job->output)->length += (size_t)num_read;
+		return true;
+	}
+
+	close(job->output_fd);
+	while (waitpid(job->pid, &job->status, 0) < 0 && errno == EINTR) {
+	}
+	job->time_ms = rktest_timer_stop(&job->timer);
+	job->is_done = true;
+	return false;
+}
+
+// Prints a finished job as if the test had run in this process
+static bool print_job(const rktest_job_t* job, const rktest_config_t* config) {
+	fwrite(job->output, 1, vec_len(job->output), stdout);
+
+	if (job->is_started && WIFEXITED(job->status) && WEXITSTATUS(job->status) <= 1) {
+		return WEXITSTATUS(job->status) == 0;
+	}
+
+	if (!job->is_started) {
+		rktest_log_error("error: ", "Could not start a process for the test\n");
+	} else if (WIFSIGNALED(job->status)) {
+		rktest_log_error("error: ", "Test crashed with signal %d\n", WTERMSIG(job->status));
+	} else {
+		rktest_log_error("error: ", "Test exited with code %d\n", WEXITSTATUS(job->status));
+	}
+	rktest_printf_red("[  FAILED  ] ");
+	printf("%s.%s ", job->test->suite_name, job->test->test_name);
+	if (config->print_timestamps_enabled) {
+		printf("(%d ms)", job->time_ms);
+	}
+	printf("\n");
+
+	return false;
+}
+
+// Same as run_all_tests(), but runs up to `config->num_jobs` tests at a time in
+// child processes. Results are printed in test order as soon as all tests
+// before them are done.
+static rktest_report_t run_all_tests_parallel(rktest_environment_t* env, const rktest_config_t* config) {
+	rktest_report_t report = { 0 };
+	vec_t(rktest_job_t) jobs = vec_new();
+	vec_t(struct pollfd) poll_fds = vec_new();
+	vec_t(rktest_job_t*) polled_jobs = vec_new();
+
+	vec_foreach(const rktest_suite_t*, suite, env->test_suites) {
+		/* Skip suite if all cases filtered out */
+		if (suite->num_disabled_tests == vec_len(suite->tests)) {
+			continue;
+		}
+		vec_foreach(const rktest_test_t*, test, suite->tests) {
+			rktest_job_t job = { 0 };
+			job.test = test;
+			job.output_fd = -1;
+			vec_push(jobs, job);
+		}
+	}
+
+	size_t next_to_start = 0;
+	size_t next_to_print = 0;
+	size_t num_running = 0;
+	rktest_millis_t suite_time_ms = 0;
+
+	while (next_to_print < vec_len(jobs)) {
+		/* Start jobs until all slots are taken */
+		while (num_running < config->num_jobs && next_to_start < vec_len(jobs)) {
+			rktest_job_t* job = &jobs[next_to_start++];
+			if (job->test->is_disabled) {
+				job->is_done = true;
+			} else if (start_job(job, config)) {
+				num_running++;
+			} else {
+				job->is_done = true;
+			}
+		}
+
+		/* Print finished jobs in order */
+		while (next_to_print < vec_len(jobs) && jobs[next_to_print].is_done) {
+			const rktest_job_t* job = &jobs[next_to_print];
+			const rktest_test_t* test = job->test;
+			const bool is_first_in_suite = next_to_print == 0 || strcmp(jobs[next_to_print - 1].test->suite_name, test->suite_name) != 0;
+			const bool is_last_in_suite = next_to_print + 1 == vec_len(jobs) || strcmp(jobs[next_to_print + 1].test->suite_name, test->suite_name) != 0;
+			const rktest_suite_t* suite = find_suite_with_name(env->test_suites, test->suite_name);
+			const size_t num_filtered_tests = vec_len(suite->tests) - suite->num_disabled_tests;
+
+			if (is_first_in_suite) {
+				rktest_log_info("[----------] ", "%zu tests from %s\n", num_filtered_tests, suite->name);
+				suite_time_ms = 0;
+			}
+
+			if (test->is_disabled) {
+				rktest_log_warning("[ DISABLED ] ", "%s.%s\n", test->suite_name, test->test_name);
+			} else if (print_job(job, config)) {
+				report.num_passed_tests++;
+			} else {
+				vec_push(report.failed_tests, *test);
+			}
+			suite_time_ms += job->time_ms;
+
+			if (is_last_in_suite) {
+				rktest_log_info("[----------] ", "%zu tests from %s ", num_filtered_tests, suite->name);
+				if (config->print_timestamps_enabled) {
+					printf("(%d ms total)", suite_time_ms);
+				}
+				printf("\n\n");
+			}
+
+			vec_free(jobs[next_to_print].output);
+			next_to_print++;
+		}
+
+		if (num_running == 0) {
+			continue;
+		}
+
+		/* Wait for output from any running job */
+		if (poll_fds) {
+			vec_header(poll_fds)->length = 0;
+			vec_header(polled_jobs)->length = 0;
+		}
+		for (size_t i = next_to_print; i < next_to_start; i++) {
+			rktest_job_t* job = &jobs[i];
+			if (job->is_started && !job->is_done) {
+				vec_push(poll_fds, (struct pollfd) { .fd = job->output_fd, .events = POLLIN });
+				vec_push(polled_jobs, job);
+			}
+		}
+
+		if (poll(poll_fds, (nfds_t)vec_len(poll_fds), -1) < 0) {
+			continue;
+		}
+
+		for (size_t i = 0; i < vec_len(poll_fds); i++) {
+			if (poll_fds[i].revents && !read_job_output(polled_jobs[i])) {
+				num_running--;
+			}
+		}
+	}
+
+	fflush(stdout);
+	vec_free(polled_jobs);
+	vec_free(poll_fds);
+	vec_free(jobs);
+
+	return report;
+}
+#endif // RKTEST_HAS_FORK
+
 static void print_failed_tests(rktest_report_t* report) {
 	rktest_log_error("[  FAILED  ] ", "%zu tests, listed below:\n", vec_len(report->failed_tests));
 	vec_foreach(const rktest_test_t*, failed_test, report->failed_tests) {
@@ -1187,14 +2112,42 @@ int rktest_main(int argc, const char* argv[]) {
 	rktest_config_t config = initialize(argc, argv);
 	rktest_environment_t env = setup_test_env(&config);
 
+	if (*config.bench_baseline && !load_bench_baseline(config.bench_baseline)) {
+		fprintf(stderr, "Error: Could not read benchmark baseline %s\n", config.bench_baseline);
+		free_bench_results();
+		free_test_env(&env);
+		return 1;
+	}
+
 	if (*config.test_filter) {
 		rktest_printf_yellow("Note: Test filter = %s\n", config.test_filter);
 	}
 	rktest_log_info("[==========] ", "Running %zu tests from %zu test suites.\n", env.total_num_filtered_tests, env.total_num_filtered_suites);
 	rktest_log_info("[----------] ", "Global test environment set-up.\n");
 
+	if (config.run_benchmarks && config.bench_counters && !open_counters()) {
+#ifdef RKTEST_HAS_PERF_COUNTERS
+		rktest_printf_yellow("Note: Could not open performance counters (%s), check /proc/sys/kernel/perf_event_paranoid\n", strerror(errno));
+#else
+		rktest_printf_yellow("Note: --rktest_bench_counters is not supported on this platform\n");
+#endif
+	}
+
 	rktest_timer_t total_time_timer = rktest_timer_start();
+	/* Benchmarks running side by side would disturb each other's timings */
+	if (config.run_benchmarks && config.num_jobs > 1) {
+		rktest_printf_yellow("Note: benchmarks always run serially, ignoring --rktest_jobs\n");
+		config.num_jobs = 1;
+	}
+
+#ifdef RKTEST_HAS_FORK
+	rktest_report_t report = config.num_jobs > 1 ? run_all_tests_parallel(&env, &config) : run_all_tests(&env, &config);
+#else
+	if (config.num_jobs > 1) {
+		rktest_printf_yellow("Note: --rktest_jobs is not supported on this platform, running tests serially\n");
+	}
 	rktest_report_t report = run_all_tests(&env, &config);
+#endif
 	rktest_millis_t total_time_ms = rktest_timer_stop(&total_time_timer);
 
 	rktest_log_info("[----------] ", "Global test environment tear-down.\n");
@@ -1217,10 +2170,18 @@ int rktest_main(int argc, const char* argv[]) {
 		rktest_printf_yellow("  YOU HAVE %zu DISABLED TEST%s\n", env.total_num_disabled_tests, env.total_num_disabled_tests > 1 ? "S" : "");
 	}
 
+	bool output_failed = false;
+	if (*config.bench_output && !write_bench_results(config.bench_output)) {
+		fprintf(stderr, "Error: Could not write benchmark results to %s\n", config.bench_output);
+		output_failed = true;
+	}
+
+	close_counters();
+	free_bench_results();
 	free_test_report(&report);
 	free_test_env(&env);
 
-	return tests_failed;
+	return tests_failed || output_failed;
 }
 
 #endif /* DEFINE_RKTEST_IMPLEMENTATION */
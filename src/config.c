@@ -0,0 +1,408 @@
+#include "config.h"
+
+#include "config_snapshot.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#define CONFIG_PAGE_SIZE 256        // Entries per page, pages never move
+
+typedef struct ConfigEntry {
+    ConfigValue value;
+    uint32_t hash;
+    uint32_t generation;        // Last reload that saw the key
+    char *section;              // "section\0name\0", one allocation
+    const char *name;
+} ConfigEntry;
+
+struct Config {
+    ConfigEntry **pages;
+    int pageCount;
+    int count;
+    ConfigEntry **buckets;      // Open addressing, power of two
+    uint32_t bucketMask;
+
+    char *iniPath;
+    char *snapshotPath;
+    uint64_t sourceHash;
+    uint32_t generation;
+
+    // Change detection
+    int watchFd;                // inotify descriptor, -1 to poll with stat()
+    const char *watchName;      // File name within the watched directory
+    struct stat lastStat;
+};
+
+static uint32_t config_hash(const char *section, const char *name)
+{
+    uint32_t h = 2166136261u;
+    for (; *section; section++) {
+        h = (h ^ (unsigned char)*section) * 16777619u;
+    }
+
+    h *= 16777619u;             // Separator, so "ab"/"c" != "a"/"bc"
+    for (; *name; name++) {
+        h = (h ^ (unsigned char)*name) * 16777619u;
+    }
+
+    return h;
+}
+
+static ConfigEntry *config_lookup(const Config *config, uint32_t hash, const char *section, const char *name)
+{
+    if (!config->buckets) {
+        return NULL;
+    }
+
+    for (uint32_t i = hash & config->bucketMask;; i = (i + 1) & config->bucketMask) {
+        ConfigEntry *e = config->buckets[i];
+        if (!e) {
+            return NULL;
+        }
+
+        if (e->hash == hash && !strcmp(e->name, name) && !strcmp(e->section, section)) {
+            return e;
+        }
+    }
+}
+
+static void config_grow(Config *config)
+{
+    uint32_t bucketCount = config->buckets ? (config->bucketMask + 1) * 2 : 64;
+    ConfigEntry **buckets = calloc(bucketCount, sizeof(ConfigEntry *));
+
+    for (int i = 0; i < config->count; i++) {
+        ConfigEntry *e = &config->pages[i / CONFIG_PAGE_SIZE][i % CONFIG_PAGE_SIZE];
+        uint32_t b = e->hash & (bucketCount - 1);
+        while (buckets[b]) {
+            b = (b + 1) & (bucketCount - 1);
+        }
+        buckets[b] = e;
+    }
+
+    free(config->buckets);
+    config->buckets = buckets;
+    config->bucketMask = bucketCount - 1;
+}
+
+static ConfigEntry *config_insert(Config *config, uint32_t hash, const char *section, const char *name)
+{
+    ConfigEntry *e = config_lookup(config, hash, section, name);
+    if (e) {
+        return e;
+    }
+
+    // Keep the load factor at or below one half
+    if (!config->buckets || (uint32_t)(config->count + 1) * 2 > config->bucketMask + 1) {
+        config_grow(config);
+    }
+
+    if (config->count == config->pageCount * CONFIG_PAGE_SIZE) {
+        config->pages = realloc(config->pages, (size_t)(config->pageCount + 1) * sizeof(ConfigEntry *));
+        config->pages[config->pageCount++] = calloc(CONFIG_PAGE_SIZE, sizeof(ConfigEntry));
+    }
+
+    e = &config->pages[config->count / CONFIG_PAGE_SIZE][config->count % CONFIG_PAGE_SIZE];
+    config->count++;
+
+    size_t sectionLength = strlen(section) + 1;
+    size_t nameLength = strlen(name) + 1;
+    e->hash = hash;
+    e->section = malloc(sectionLength + nameLength);
+    memcpy(e->section, section, sectionLength);
+    memcpy(e->section + sectionLength, name, nameLength);
+    e->name = e->section + sectionLength;
+
+    uint32_t b = hash & config->bucketMask;
+    while (config->buckets[b]) {
+        b = (b + 1) & config->bucketMask;
+    }
+    config->buckets[b] = e;
+
+    return e;
+}
+
+static bool config_equals_nocase(const char *a, const char *b)
+{
+    for (; *a && *b; a++, b++) {
+        if (tolower((unsigned char)*a) != tolower((unsigned char)*b)) {
+            return false;
+        }
+    }
+
+    return *a == *b;
+}
+
+static bool config_parse_bool(const char *s, bool *out)
+{
+    static const char *const truthy[] = { "true", "yes", "on", "1" };
+    static const char *const falsy[] = { "false", "no", "off", "0" };
+
+    for (int i = 0; i < 4; i++) {
+        if (config_equals_nocase(s, truthy[i])) {
+            *out = true;
+            return true;
+        }
+        if (config_equals_nocase(s, falsy[i])) {
+            *out = false;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static char *config_strdup(const char *s)
+{
+    size_t length = strlen(s) + 1;
+    char *copy = malloc(length);
+    memcpy(copy, s, length);
+
+    return copy;
+}
+
+// Converts the string once so reads never parse
+static void config_assign(ConfigValue *value, const char *string)
+{
+    free((char *)value->string);
+    *value = (ConfigValue){ .flags = CONFIG_VALUE_PRESENT, .string = config_strdup(string) };
+
+    if (!*string) {
+        return;
+    }
+
+    char *end;
+    errno = 0;
+    long i = strtol(string, &end, 10);
+    if (!*end && !errno && i >= -2147483647L - 1 && i <= 2147483647L) {
+        value->flags |= CONFIG_VALUE_INT;
+        value->asInt = (int)i;
+    }
+
+    float f = strtof(string, &end);
+    if (!*end && !isspace((unsigned char)*string)) {
+        value->flags |= CONFIG_VALUE_FLOAT;
+        value->asFloat = f;
+    }
+
+    if (config_parse_bool(string, &value->asBool)) {
+        value->flags |= CONFIG_VALUE_BOOL;
+    }
+}
+
+static void config_watch(Config *config)
+{
+    config->watchFd = -1;
+    config->watchName = strrchr(config->iniPath, '/');
+    config->watchName = config->watchName ? config->watchName + 1 : config->iniPath;
+
+    if (stat(config->iniPath, &config->lastStat)) {
+        memset(&config->lastStat, 0, sizeof(config->lastStat));
+    }
+
+#ifdef __linux__
+    // Watch the directory rather than the file: editors often save by
+    // writing a new file and renaming it over the old one.
+    size_t dirLength = (size_t)(config->watchName - config->iniPath);
+    char *dir = dirLength ? malloc(dirLength + 1) : config_strdup(".");
+    if (dirLength) {
+        memcpy(dir, config->iniPath, dirLength);
+        dir[dirLength] = '\0';
+    }
+
+    config->watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (config->watchFd >= 0 &&
+        inotify_add_watch(config->watchFd, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        close(config->watchFd);
+        config->watchFd = -1;
+    }
+
+    free(dir);
+#endif
+}
+
+Config *config_load(const char *iniPath, const char *snapshotPath)
+{
+    Config *config = calloc(1, sizeof(Config));
+    config->watchFd = -1; // config_free() closes it if the first load fails
+    config->iniPath = config_strdup(iniPath);
+    config->snapshotPath = config_strdup(snapshotPath);
+
+    if (config_reload(config, NULL, NULL) < 0) {
+        config_free(config);
+        return NULL;
+    }
+
+    config_watch(config);
+
+    return config;
+}
+
+bool config_poll(Config *config)
+{
+    if (!config) {
+        return false;
+    }
+
+#ifdef __linux__
+    if (config->watchFd >= 0) {
+        bool changed = false;
+        char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t length;
+
+        while ((length = read(config->watchFd, buffer, sizeof(buffer))) > 0) {
+            for (char *p = buffer; p < buffer + length;) {
+                const struct inotify_event *event = (const struct inotify_event *)p;
+                if (event->len && !strcmp(event->name, config->watchName)) {
+                    changed = true;
+                }
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+
+        return changed;
+    }
+#endif
+
+    struct stat st;
+    if (stat(config->iniPath, &st)) {
+        return false;
+    }
+
+    bool changed = st.st_mtime != config->lastStat.st_mtime || st.st_size != config->lastStat.st_size;
+    config->lastStat = st;
+
+    return changed;
+}
+
+int config_reload(Config *config, ConfigChangedAction action, void *ctx)
+{
+    ConfigSnapshot *snapshot = config_snapshot_open(config->iniPath, config->snapshotPath);
+    if (!snapshot) {
+        return -1;
+    }
+
+    // Saved without changes
+    uint64_t sourceHash = config_snapshot_source_hash(snapshot);
+    if (config->generation && sourceHash == config->sourceHash) {
+        config_snapshot_close(snapshot);
+        return 0;
+    }
+
+    config->sourceHash = sourceHash;
+    config->generation++;
+
+    int changed = 0;
+    int count = config_snapshot_count(snapshot);
+
+    for (int i = 0; i < count; i++) {
+        const char *section, *name, *value;
+        config_snapshot_entry(snapshot, i, &section, &name, &value);
+
+        ConfigEntry *e = config_insert(config, config_hash(section, name), section, name);
+        e->generation = config->generation;
+
+        if (!(e->value.flags & CONFIG_VALUE_PRESENT) || strcmp(e->value.string, value)) {
+            config_assign(&e->value, value);
+            changed++;
+
+            if (action) {
+                action(e->section, e->name, &e->value, ctx);
+            }
+        }
+    }
+
+    config_snapshot_close(snapshot);
+
+    // Keys that weren't in this version of the file
+    for (int i = 0; i < config->count; i++) {
+        ConfigEntry *e = &config->pages[i / CONFIG_PAGE_SIZE][i % CONFIG_PAGE_SIZE];
+        if ((e->value.flags & CONFIG_VALUE_PRESENT) && e->generation != config->generation) {
+            free((char *)e->value.string);
+            e->value = (ConfigValue){ 0 };
+            changed++;
+
+            if (action) {
+                action(e->section, e->name, &e->value, ctx);
+            }
+        }
+    }
+
+    return changed;
+}
+
+const ConfigValue *config_find(const Config *config, const char *section, const char *name)
+{
+    if (!config) {
+        return NULL;
+    }
+
+    ConfigEntry *e = config_lookup(config, config_hash(section, name), section, name);
+    return (e && (e->value.flags & CONFIG_VALUE_PRESENT)) ? &e->value : NULL;
+}
+
+const ConfigValue *config_handle(Config *config, const char *section, const char *name)
+{
+    if (!config) {
+        return NULL;
+    }
+
+    return &config_insert(config, config_hash(section, name), section, name)->value;
+}
+
+int config_int(const Config *config, const char *section, const char *name, int fallback)
+{
+    return config_value_int(config_find(config, section, name), fallback);
+}
+
+float config_float(const Config *config, const char *section, const char *name, float fallback)
+{
+    return config_value_float(config_find(config, section, name), fallback);
+}
+
+bool config_bool(const Config *config, const char *section, const char *name, bool fallback)
+{
+    return config_value_bool(config_find(config, section, name), fallback);
+}
+
+const char *config_string(const Config *config, const char *section, const char *name, const char *fallback)
+{
+    return config_value_string(config_find(config, section, name), fallback);
+}
+
+void config_free(Config *config)
+{
+    if (!config) {
+        return;
+    }
+
+    for (int i = 0; i < config->count; i++) {
+        ConfigEntry *e = &config->pages[i / CONFIG_PAGE_SIZE][i % CONFIG_PAGE_SIZE];
+        free(e->section);
+        free((char *)e->value.string);
+    }
+
+    for (int i = 0; i < config->pageCount; i++) {
+        free(config->pages[i]);
+    }
+
+#ifdef __linux__
+    if (config->watchFd >= 0) {
+        close(config->watchFd);
+    }
+#endif
+
+    free(config->pages);
+    free(config->buckets);
+    free(config->iniPath);
+    free(config->snapshotPath);
+    free(config);
+}
@@ -0,0 +1,96 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Typed configuration store.
+//
+// Loads an INI file (through its snapshot, see config_snapshot.h) into a
+// hash table keyed by (section, name). Every value is converted once at load
+// time, so the typed getters are a hash lookup plus a load, and never compare
+// strings in a chain like an ini_handler would.
+//
+//      Config *config = config_load("config/setup.cfg", "config/setup.cfg.bin");
+//      int width = config_int(config, "window", "width", 800);
+//
+// Code that reads a value every frame can resolve it to a handle once and
+// read through that without hashing:
+//
+//      const ConfigValue *timeScale = config_handle(config, "simulation", "timeScale");
+//      float scale = config_value_float(timeScale, 1.0f);
+//
+// A handle stays valid until config_free(), including for keys that don't
+// exist yet: reading it returns the fallback until a reload adds the key.
+//
+// The store watches its INI file (inotify on Linux, mtime polling elsewhere).
+// When config_poll() reports a change, config_reload() re-reads the file and
+// updates the affected values in place, calling back only for the keys that
+// were added, changed or removed.
+
+#define CONFIG_VALUE_PRESENT 0x01
+#define CONFIG_VALUE_INT 0x02
+#define CONFIG_VALUE_FLOAT 0x04
+#define CONFIG_VALUE_BOOL 0x08
+
+typedef struct ConfigValue {
+    unsigned int flags;         // CONFIG_VALUE_*, which conversions succeeded
+    int asInt;
+    float asFloat;
+    bool asBool;
+    const char *string;         // Valid until the value changes
+} ConfigValue;
+
+typedef struct Config Config;
+
+// Called by config_reload() for each changed key. `value` is the key's handle;
+// its flags are 0 if the key was removed.
+typedef void (*ConfigChangedAction)(const char *section, const char *name, const ConfigValue *value, void *ctx);
+
+// Returns NULL if the file can't be read or has errors.
+Config *config_load(const char *iniPath, const char *snapshotPath);
+
+// Returns the value of the key, or NULL if it isn't set.
+const ConfigValue *config_find(const Config *config, const char *section, const char *name);
+
+// Returns a handle to the key, adding an unset slot for it if needed. Returns
+// NULL if `config` is NULL; the config_value_* readers accept NULL handles.
+const ConfigValue *config_handle(Config *config, const char *section, const char *name);
+
+// Typed lookups. `config` may be NULL, in which case the fallback is returned.
+int config_int(const Config *config, const char *section, const char *name, int fallback);
+float config_float(const Config *config, const char *section, const char *name, float fallback);
+bool config_bool(const Config *config, const char *section, const char *name, bool fallback);
+const char *config_string(const Config *config, const char *section, const char *name, const char *fallback);
+
+// Non-blocking. Returns true if the INI file changed since the last call.
+bool config_poll(Config *config);
+
+// Re-reads the INI file and applies the differences. Returns the number of
+// changed keys, or -1 if the file can't be read or has errors, in which case
+// all values are kept.
+int config_reload(Config *config, ConfigChangedAction action, void *ctx);
+
+void config_free(Config *config);
+
+static inline int config_value_int(const ConfigValue *value, int fallback)
+{
+    return (value && (value->flags & CONFIG_VALUE_INT)) ? value->asInt : fallback;
+}
+
+static inline float config_value_float(const ConfigValue *value, float fallback)
+{
+    return (value && (value->flags & CONFIG_VALUE_FLOAT)) ? value->asFloat : fallback;
+}
+
+static inline bool config_value_bool(const ConfigValue *value, bool fallback)
+{
+    return (value && (value->flags & CONFIG_VALUE_BOOL)) ? value->asBool : fallback;
+}
+
+static inline const char *config_value_string(const ConfigValue *value, const char *fallback)
+{
+    return (value && (value->flags & CONFIG_VALUE_PRESENT)) ? value->string : fallback;
+}
+
+#endif
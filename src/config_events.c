@@ -0,0 +1,37 @@
+#include "config_events.h"
+
+ECS_COMPONENT_DECLARE(ConfigSource);
+ECS_COMPONENT_DECLARE(ConfigChange);
+
+void config_events_init(ecs_world_t *world, Config *config)
+{
+    ECS_COMPONENT_DEFINE(world, ConfigSource);
+    ECS_COMPONENT_DEFINE(world, ConfigChange);
+    ecs_add_id(world, ecs_id(ConfigSource), EcsSingleton);
+
+    ecs_singleton_set(world, ConfigSource, { config });
+}
+
+static void config_events_emit(const char *section, const char *name, const ConfigValue *value, void *ctx)
+{
+    ecs_world_t *world = ctx;
+    ConfigChange change = { section, name, value };
+
+    ecs_emit(world, &(ecs_event_desc_t){
+        .event = ecs_id(ConfigChange),
+        .ids = &(ecs_type_t){ .array = (ecs_id_t[]){ ecs_id(ConfigSource) }, .count = 1 },
+        .entity = ecs_id(ConfigSource),
+        .param = &change
+    });
+}
+
+int config_events_poll(ecs_world_t *world)
+{
+    const ConfigSource *source = ecs_singleton_get(world, ConfigSource);
+    if (!source->config || !config_poll(source->config)) {
+        return 0;
+    }
+
+    int changed = config_reload(source->config, config_events_emit, world);
+    return changed > 0 ? changed : 0;
+}
@@ -0,0 +1,49 @@
+#ifndef CONFIG_EVENTS_H
+#define CONFIG_EVENTS_H
+
+#include <flecs/flecs.h>
+
+#include "config.h"
+
+// Delivers config hot reloads as Flecs events.
+//
+// The store is kept in the ConfigSource singleton. config_events_poll()
+// reloads it when its file changed and emits one ConfigChange event per
+// added, changed or removed key, so observers only run for what changed:
+//
+//      static void OnConfigChange(ecs_iter_t *it)
+//      {
+//          const ConfigChange *change = it->param;
+//          if (change->value == timeScaleHandle) { ... }
+//      }
+//
+//      ecs_observer(world, {
+//          .query.terms = {{ ecs_id(ConfigSource) }},
+//          .events = { ecs_id(ConfigChange) },
+//          .callback = OnConfigChange
+//      });
+//
+// Handles from config_handle() compare equal to `value` for their key.
+
+typedef struct ConfigSource {
+    Config *config;
+} ConfigSource;
+
+// Event, with itself as the payload
+typedef struct ConfigChange {
+    const char *section;
+    const char *name;
+    const ConfigValue *value;   // flags are 0 if the key was removed
+} ConfigChange;
+
+extern ECS_COMPONENT_DECLARE(ConfigSource);
+extern ECS_COMPONENT_DECLARE(ConfigChange);
+
+// Registers the components and stores `config` (may be NULL) in the singleton.
+void config_events_init(ecs_world_t *world, Config *config);
+
+// Reloads the config if its file changed and emits the changes. Must be
+// called outside of ecs_progress(). Returns the number of events emitted.
+int config_events_poll(ecs_world_t *world);
+
+#endif
@@ -0,0 +1,476 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L     // st_mtim under -std=c99
+#endif
+
+#include "config_snapshot.h"
+
+#include <inih/ini.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define CONFIG_SNAPSHOT_MAGIC 0x47464343u    // "CCFG"
+#define CONFIG_SNAPSHOT_VERSION 1u
+
+// On-disk layout: header, entries[entryCount], strings[stringsSize]. Stored
+// in native byte order; a snapshot from another machine fails validation
+// and is recompiled.
+typedef struct ConfigSnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceMtime;
+    uint64_t sourceSize;
+    uint64_t sourceHash;
+    uint32_t entryCount;
+    uint32_t stringsSize;
+} ConfigSnapshotHeader;
+
+typedef struct ConfigSnapshotEntry {
+    uint32_t hash;              // config_snapshot_key_hash(section, name)
+    uint32_t section;           // Offsets into the string table
+    uint32_t name;
+    uint32_t value;
+} ConfigSnapshotEntry;
+
+struct ConfigSnapshot {
+    void *data;
+    size_t size;
+    bool mapped;                // munmap() instead of free()
+    const ConfigSnapshotHeader *header;
+    const ConfigSnapshotEntry *entries;
+    const char *strings;
+};
+
+// Collects handler callbacks while compiling
+typedef struct ConfigSnapshotBuilder {
+    ConfigSnapshotEntry *entries;
+    int count;
+    int capacity;
+    char *strings;
+    uint32_t stringsSize;
+    uint32_t stringsCapacity;
+    uint32_t lastSection;
+    const char *lastName;       // Name view of the last entry, in the INI text
+} ConfigSnapshotBuilder;
+
+static uint64_t config_snapshot_hash64(const char *data, size_t size)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        h = (h ^ (unsigned char)data[i]) * 1099511628211ull;
+    }
+
+    return h;
+}
+
+static uint32_t config_snapshot_key_hash(const char *section, size_t sectionLength,
+                                         const char *name, size_t nameLength)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < sectionLength; i++) {
+        h = (h ^ (unsigned char)section[i]) * 16777619u;
+    }
+
+    h *= 16777619u;             // Separator, so "ab"/"c" != "a"/"bc"
+    for (size_t i = 0; i < nameLength; i++) {
+        h = (h ^ (unsigned char)name[i]) * 16777619u;
+    }
+
+    return h;
+}
+
+// Nanoseconds where available: a hot reloaded file can be saved several
+// times within the same second.
+static uint64_t config_snapshot_mtime(const struct stat *st)
+{
+#ifdef __linux__
+    return (uint64_t)st->st_mtim.tv_sec * 1000000000u + (uint64_t)st->st_mtim.tv_nsec;
+#else
+    return (uint64_t)st->st_mtime;
+#endif
+}
+
+// Maps a whole file, or reads it where mapping isn't available. Returns NULL if it can't be opened.
+static void *config_snapshot_read(const char *path, size_t *size, bool *mapped)
+{
+    *mapped = false;
+
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    // Empty files can't be mapped and take the fallback below
+    struct stat st;
+    void *mapping = MAP_FAILED;
+    if (!fstat(fd, &st) && st.st_size > 0) {
+        mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+
+    if (mapping != MAP_FAILED) {
+        *size = (size_t)st.st_size;
+        *mapped = true;
+        return mapping;
+    }
+#endif
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *data = malloc(length > 0 ? (size_t)length : 1);
+    if (length < 0 || fread(data, 1, (size_t)length, file) != (size_t)length) {
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+
+    fclose(file);
+    *size = (size_t)length;
+    return data;
+}
+
+static uint32_t config_snapshot_add_string(ConfigSnapshotBuilder *b, ini_view s)
+{
+    uint32_t length = (uint32_t)s.len + 1;
+    if (b->stringsSize + length > b->stringsCapacity) {
+        while (b->stringsSize + length > b->stringsCapacity) {
+            b->stringsCapacity = b->stringsCapacity ? b->stringsCapacity * 2 : 4096;
+        }
+        b->strings = realloc(b->strings, b->stringsCapacity);
+    }
+
+    uint32_t offset = b->stringsSize;
+    if (s.len) {
+        memcpy(b->strings + offset, s.ptr, s.len);
+    }
+    b->strings[offset + s.len] = '\0';
+    b->stringsSize += length;
+
+    return offset;
+}
+
+static bool config_snapshot_equals(const ConfigSnapshotBuilder *b, uint32_t offset, ini_view s)
+{
+    return !strncmp(b->strings + offset, s.ptr, s.len) && b->strings[offset + s.len] == '\0';
+}
+
+static int config_snapshot_handler(void *user, ini_view section, ini_view name, ini_view value)
+{
+    ConfigSnapshotBuilder *b = user;
+
+    // Continuation line of a multi-line value, which ini_parse_buffer() passes
+    // with the name view of the line that started it. A repeated key has a name
+    // of its own and is added as a new entry, so that the last one wins. The
+    // value is always the last string added, so it can be extended in place.
+    if (b->count && name.ptr == b->lastName) {
+        b->strings[b->stringsSize - 1] = '\n';
+        config_snapshot_add_string(b, value);
+        return 1;
+    }
+
+    if (b->count == b->capacity) {
+        b->capacity = b->capacity ? b->capacity * 2 : 256;
+        b->entries = realloc(b->entries, (size_t)b->capacity * sizeof(ConfigSnapshotEntry));
+    }
+
+    // Sections arrive in runs, so only a change of section adds a string
+    if (!b->count || !config_snapshot_equals(b, b->lastSection, section)) {
+        b->lastSection = config_snapshot_add_string(b, section);
+    }
+
+    ConfigSnapshotEntry *e = &b->entries[b->count++];
+    e->hash = config_snapshot_key_hash(section.ptr, section.len, name.ptr, name.len);
+    e->section = b->lastSection;
+    e->name = config_snapshot_add_string(b, name);
+    e->value = config_snapshot_add_string(b, value);
+    b->lastName = name.ptr;
+
+    return 1;
+}
+
+// Sorts by key, keeping the order of equal keys so the last one can be kept.
+// qsort() isn't stable, hence the tie break on the name offset, which grows
+// with the position in the file.
+static const ConfigSnapshotBuilder *config_snapshot_sorting;
+
+static int config_snapshot_compare(const void *lhs, const void *rhs)
+{
+    const ConfigSnapshotEntry *a = lhs;
+    const ConfigSnapshotEntry *b = rhs;
+    const char *strings = config_snapshot_sorting->strings;
+
+    if (a->hash != b->hash) return (a->hash < b->hash) ? -1 : 1;
+
+    int cmp = strcmp(strings + a->section, strings + b->section);
+    if (cmp) return cmp;
+
+    cmp = strcmp(strings + a->name, strings + b->name);
+    if (cmp) return cmp;
+
+    return (a->name < b->name) ? -1 : 1;
+}
+
+static bool config_snapshot_same_key(const char *strings, const ConfigSnapshotEntry *a, const ConfigSnapshotEntry *b)
+{
+    return a->hash == b->hash && !strcmp(strings + a->section, strings + b->section) &&
+           !strcmp(strings + a->name, strings + b->name);
+}
+
+// Parses INI text into a complete snapshot image
+static void *config_snapshot_compile(const char *text, size_t textSize, const struct stat *source, size_t *size)
+{
+    ConfigSnapshotBuilder b = { 0 };
+
+    if (ini_parse_buffer(text, textSize, config_snapshot_handler, &b)) {
+        free(b.entries);
+        free(b.strings);
+        return NULL;
+    }
+
+    config_snapshot_sorting = &b;
+    qsort(b.entries, (size_t)b.count, sizeof(ConfigSnapshotEntry), config_snapshot_compare);
+    config_snapshot_sorting = NULL;
+
+    int count = 0;
+    for (int i = 0; i < b.count; i++) {
+        if (i + 1 < b.count && config_snapshot_same_key(b.strings, &b.entries[i], &b.entries[i + 1])) {
+            continue;
+        }
+        b.entries[count++] = b.entries[i];
+    }
+
+    ConfigSnapshotHeader header = {
+        .magic = CONFIG_SNAPSHOT_MAGIC,
+        .version = CONFIG_SNAPSHOT_VERSION,
+        .sourceMtime = config_snapshot_mtime(source),
+        .sourceSize = (uint64_t)source->st_size,
+        .sourceHash = config_snapshot_hash64(text, textSize),
+        .entryCount = (uint32_t)count,
+        .stringsSize = b.stringsSize
+    };
+
+    *size = sizeof(header) + (size_t)count * sizeof(ConfigSnapshotEntry) + b.stringsSize;
+    char *data = malloc(*size);
+    memcpy(data, &header, sizeof(header));
+    if (count) {
+        memcpy(data + sizeof(header), b.entries, (size_t)count * sizeof(ConfigSnapshotEntry));
+    }
+    if (b.stringsSize) {
+        memcpy(data + sizeof(header) + (size_t)count * sizeof(ConfigSnapshotEntry), b.strings, b.stringsSize);
+    }
+
+    free(b.entries);
+    free(b.strings);
+
+    return data;
+}
+
+// Writes through a temporary file so a crash never leaves a torn snapshot
+static void config_snapshot_write(const char *path, const void *data, size_t size)
+{
+    char tmpPath[4096];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+
+    FILE *file = fopen(tmpPath, "wb");
+    if (!file) {
+        return;
+    }
+
+    bool written = fwrite(data, 1, size, file) == size;
+    written = !fclose(file) && written;
+
+#ifdef _WIN32
+    remove(path);
+#endif
+    if (!written || rename(tmpPath, path)) {
+        remove(tmpPath);
+    }
+}
+
+static bool config_snapshot_bind(ConfigSnapshot *snapshot)
+{
+    const char *data = snapshot->data;
+    const ConfigSnapshotHeader *header = snapshot->data;
+
+    if (snapshot->size < sizeof(*header) || header->magic != CONFIG_SNAPSHOT_MAGIC ||
+        header->version != CONFIG_SNAPSHOT_VERSION) {
+        return false;
+    }
+
+    size_t entriesSize = (size_t)header->entryCount * sizeof(ConfigSnapshotEntry);
+    if (snapshot->size != sizeof(*header) + entriesSize + header->stringsSize) {
+        return false;
+    }
+
+    snapshot->header = header;
+    snapshot->entries = (const ConfigSnapshotEntry *)(data + sizeof(*header));
+    snapshot->strings = data + sizeof(*header) + entriesSize;
+
+    if (header->stringsSize && snapshot->strings[header->stringsSize - 1] != '\0') {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header->entryCount; i++) {
+        const ConfigSnapshotEntry *e = &snapshot->entries[i];
+        if (e->section >= header->stringsSize || e->name >= header->stringsSize ||
+            e->value >= header->stringsSize) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void config_snapshot_unmap(void *data, size_t size, bool mapped)
+{
+#ifndef _WIN32
+    if (mapped) {
+        munmap(data, size);
+        return;
+    }
+#else
+    (void)size;
+    (void)mapped;
+#endif
+    free(data);
+}
+
+static void config_snapshot_release(ConfigSnapshot *snapshot)
+{
+    if (snapshot->data) {
+        config_snapshot_unmap(snapshot->data, snapshot->size, snapshot->mapped);
+        snapshot->data = NULL;
+    }
+}
+
+ConfigSnapshot *config_snapshot_open(const char *iniPath, const char *snapshotPath)
+{
+    ConfigSnapshot *snapshot = calloc(1, sizeof(ConfigSnapshot));
+    struct stat source;
+    bool hasSource = !stat(iniPath, &source);
+
+    snapshot->data = config_snapshot_read(snapshotPath, &snapshot->size, &snapshot->mapped);
+    if (snapshot->data) {
+        if (!config_snapshot_bind(snapshot)) {
+            config_snapshot_release(snapshot);
+        } else if (!hasSource || (snapshot->header->sourceMtime == config_snapshot_mtime(&source) &&
+                                  snapshot->header->sourceSize == (uint64_t)source.st_size)) {
+            return snapshot;
+        }
+    }
+
+    if (!hasSource) {
+        free(snapshot);
+        return NULL;
+    }
+
+    bool mapped;
+    size_t textSize;
+    char *text = config_snapshot_read(iniPath, &textSize, &mapped);
+    if (!text) {
+        config_snapshot_release(snapshot);
+        free(snapshot);
+        return NULL;
+    }
+
+    // Touched but not changed: keep the snapshot, only refresh its mtime
+    if (snapshot->data && snapshot->header->sourceHash == config_snapshot_hash64(text, textSize) &&
+        snapshot->header->sourceSize == (uint64_t)textSize) {
+        ConfigSnapshotHeader header = *snapshot->header;
+        header.sourceMtime = config_snapshot_mtime(&source);
+
+        FILE *file = fopen(snapshotPath, "r+b");
+        if (file) {
+            fwrite(&header, sizeof(header), 1, file);
+            fclose(file);
+        }
+    } else {
+        config_snapshot_release(snapshot);
+
+        snapshot->data = config_snapshot_compile(text, textSize, &source, &snapshot->size);
+        snapshot->mapped = false;
+        if (snapshot->data) {
+            config_snapshot_write(snapshotPath, snapshot->data, snapshot->size);
+            config_snapshot_bind(snapshot);
+        }
+    }
+
+    config_snapshot_unmap(text, textSize, mapped);
+
+    if (!snapshot->data) {
+        free(snapshot);
+        return NULL;
+    }
+
+    return snapshot;
+}
+
+const char *config_snapshot_find(const ConfigSnapshot *snapshot, const char *section, const char *name)
+{
+    uint32_t hash = config_snapshot_key_hash(section, strlen(section), name, strlen(name));
+    uint32_t lo = 0;
+    uint32_t hi = snapshot->header->entryCount;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (snapshot->entries[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    for (; lo < snapshot->header->entryCount && snapshot->entries[lo].hash == hash; lo++) {
+        const ConfigSnapshotEntry *e = &snapshot->entries[lo];
+        if (!strcmp(snapshot->strings + e->section, section) && !strcmp(snapshot->strings + e->name, name)) {
+            return snapshot->strings + e->value;
+        }
+    }
+
+    return NULL;
+}
+
+int config_snapshot_count(const ConfigSnapshot *snapshot)
+{
+    return (int)snapshot->header->entryCount;
+}
+
+void config_snapshot_entry(const ConfigSnapshot *snapshot, int index,
+                           const char **section, const char **name, const char **value)
+{
+    const ConfigSnapshotEntry *e = &snapshot->entries[index];
+
+    *section = snapshot->strings + e->section;
+    *name = snapshot->strings + e->name;
+    *value = snapshot->strings + e->value;
+}
+
+uint64_t config_snapshot_source_hash(const ConfigSnapshot *snapshot)
+{
+    return snapshot->header->sourceHash;
+}
+
+void config_snapshot_close(ConfigSnapshot *snapshot)
+{
+    if (snapshot) {
+        config_snapshot_release(snapshot);
+        free(snapshot);
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef CONFIG_SNAPSHOT_H
+#define CONFIG_SNAPSHOT_H
+
+#include <stdint.h>
+
+// Compiled, memory-mapped form of an INI file.
+//
+// The first open maps the text file, parses it in place with ini_parse_buffer()
+// and writes a snapshot next to it: a header, an index of (section, name,
+// value) entries sorted by key hash and a flat string table. Later opens map
+// the snapshot and look keys up with a binary search, without parsing or
+// copying anything. The text file is
+// only parsed again when its mtime or size changed and its content hash no
+// longer matches the one recorded in the snapshot.
+//
+//      ConfigSnapshot *config = config_snapshot_open("config/setup.cfg", "config/setup.cfg.bin");
+//      const char *title = config_snapshot_find(config, "window", "title");
+//
+// Keys are case sensitive. When a key appears more than once the last value
+// wins; multi-line values are joined with '\n'. All returned strings point
+// into the snapshot and stay valid until it is closed.
+
+typedef struct ConfigSnapshot ConfigSnapshot;
+
+// Opens the snapshot for `iniPath`, compiling it to `snapshotPath` first if it
+// is missing or stale. If the INI file doesn't exist an existing snapshot is
+// used as is. Returns NULL if neither can be read or the INI has errors.
+ConfigSnapshot *config_snapshot_open(const char *iniPath, const char *snapshotPath);
+
+// Returns the value of the key, or NULL if it doesn't exist.
+const char *config_snapshot_find(const ConfigSnapshot *snapshot, const char *section, const char *name);
+
+// Iterates all entries in index order.
+int config_snapshot_count(const ConfigSnapshot *snapshot);
+void config_snapshot_entry(const ConfigSnapshot *snapshot, int index,
+                           const char **section, const char **name, const char **value);
+
+// Hash of the INI text the snapshot was compiled from.
+uint64_t config_snapshot_source_hash(const ConfigSnapshot *snapshot);
+
+void config_snapshot_close(ConfigSnapshot *snapshot);
+
+#endif
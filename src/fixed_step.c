@@ -0,0 +1,71 @@
+#include "fixed_step.h"
+
+ECS_COMPONENT_DECLARE(FixedStep);
+ECS_TAG_DECLARE(FixedUpdate);
+
+// A frame longer than this is treated as a stall (debugger, window drag) and
+// is not made up for.
+#define FIXED_STEP_MAX_FRAME_TIME 0.25f
+
+void fixed_step_init(ecs_world_t *world, float hz, int maxSteps)
+{
+    ECS_COMPONENT_DEFINE(world, FixedStep);
+    ECS_TAG_DEFINE(world, FixedUpdate);
+
+    // Lets systems read the step state with a plain `[in] FixedStep` term.
+    ecs_add_id(world, ecs_id(FixedStep), EcsSingleton);
+
+    // FixedUpdate is not an EcsPhase, so systems that depend on it are never
+    // matched by the builtin pipeline that ecs_progress() runs.
+    ecs_entity_t pipeline = ecs_pipeline(world, {
+        .entity = ecs_entity(world, { .name = "FixedPipeline" }),
+        .query.terms = {
+            { .id = EcsSystem },
+            { .id = ecs_dependson(FixedUpdate) },
+            { .id = EcsDisabled, .src.id = EcsUp, .trav = EcsChildOf, .oper = EcsNot }
+        }
+    });
+
+    ecs_singleton_set(world, FixedStep, {
+        .step = 1.0f / hz,
+        .maxSteps = maxSteps,
+        .pipeline = pipeline
+    });
+}
+
+int fixed_step_advance(ecs_world_t *world, float frameTime)
+{
+    FixedStep *fs = ecs_singleton_ensure(world, FixedStep);
+
+    if (frameTime > FIXED_STEP_MAX_FRAME_TIME) {
+        frameTime = FIXED_STEP_MAX_FRAME_TIME;
+    }
+
+    fs->accumulator += frameTime;
+
+    int ticks = 0;
+    while (fs->accumulator >= fs->step) {
+        if (ticks == fs->maxSteps) {
+            // Can't keep up: drop the backlog rather than spiral, the sim
+            // runs slower than wall time until the load goes away.
+            fs->accumulator = 0.0f;
+            break;
+        }
+
+        // The pipeline may move the singleton while running, so only the
+        // values needed after the call are kept.
+        ecs_entity_t pipeline = fs->pipeline;
+        float step = fs->step;
+        ecs_run_pipeline(world, pipeline, step);
+
+        fs = ecs_singleton_ensure(world, FixedStep);
+        fs->accumulator -= step;
+        fs->ticks++;
+        ticks++;
+    }
+
+    fs->alpha = fs->accumulator / fs->step;
+    ecs_singleton_modified(world, FixedStep);
+
+    return ticks;
+}
@@ -0,0 +1,35 @@
+#ifndef FIXED_STEP_H
+#define FIXED_STEP_H
+
+#include <flecs/flecs.h>
+
+// Fixed-rate simulation on top of the Flecs pipeline.
+//
+// Systems created with the FixedUpdate phase are kept out of the builtin
+// pipeline and run from a dedicated pipeline instead, zero or more times per
+// display frame with a constant delta time. Whatever frame time is left over
+// stays in the accumulator and is exposed as `alpha` so render systems can
+// interpolate between the previous and the current simulation state.
+//
+//      ECS_SYSTEM(world, Move, FixedUpdate, Position, Velocity);
+
+typedef struct FixedStep {
+    float step;         // Seconds simulated per tick
+    float accumulator;  // Frame time not yet consumed by a tick
+    float alpha;        // accumulator / step, in [0, 1)
+    int maxSteps;       // Ticks allowed per frame before time is dropped
+    int64_t ticks;      // Total ticks simulated
+    ecs_entity_t pipeline;
+} FixedStep;
+
+extern ECS_COMPONENT_DECLARE(FixedStep);
+extern ECS_TAG_DECLARE(FixedUpdate);
+
+// Registers FixedStep/FixedUpdate and creates the fixed-rate pipeline.
+void fixed_step_init(ecs_world_t *world, float hz, int maxSteps);
+
+// Feeds one display frame worth of time into the accumulator and runs the
+// fixed-rate pipeline once per whole step. Returns the number of ticks ran.
+int fixed_step_advance(ecs_world_t *world, float frameTime);
+
+#endif
@@ -0,0 +1,470 @@
+#ifdef TEST
+#include <rktest/rktest.h>
+
+#include <flecs/flecs.h>
+
+#define CONCURRENT_SYSTEMS 8
+#define CONCURRENT_THREADS 4
+#define CONCURRENT_FRAMES 200
+
+// Largest table type to look ids up in, a few times the 16 id window that
+// flecs_type_index_of narrows larger types down to
+#define TYPE_INDEX_MAX_IDS 70
+
+// Enough rows that a sorted table has several radix digits to sort on
+#define SORT_ENTITIES 512
+
+// Sets each written component as a singleton, so on the component entity
+static void SetSingletons(ecs_iter_t *it)
+{
+    int32_t value = *(int32_t *)it->ctx;
+    for (int8_t i = 0; i < it->field_count; i++) {
+        ecs_id_t id = ecs_field_id(it, i);
+        ecs_set_id(it->world, id, id, sizeof(int32_t), &value);
+    }
+}
+
+// Counts the frames a system ran in
+static void CountFrames(ecs_iter_t *it)
+{
+    (*(int32_t *)it->ctx)++;
+}
+
+static void SleepAndCountFrames(ecs_iter_t *it)
+{
+    ecs_sleepf(0.002);
+    CountFrames(it);
+}
+
+// Concurrent systems enqueue their commands on the stage of whichever thread
+// ran them. A later system that writes the same components must still have
+// its commands applied last.
+TEST(pipeline, concurrent_commands_in_order)
+{
+    static int32_t first = 1, last = 2;
+
+    ecs_world_t *world = ecs_init();
+    ecs_entity_t components[CONCURRENT_SYSTEMS];
+    ecs_system_desc_t overwrite = { .callback = SetSingletons, .ctx = &last };
+
+    for (int i = 0; i < CONCURRENT_SYSTEMS; i++) {
+        components[i] = ecs_component_init(world, &(ecs_component_desc_t){
+            .type = { .size = sizeof(int32_t), .alignment = ECS_ALIGNOF(int32_t) }
+        });
+
+        ecs_term_t term = { .id = components[i], .src.id = EcsIsEntity, .inout = EcsOut };
+        ecs_system(world, {
+            .entity = ecs_entity(world, { .add = ecs_ids(ecs_dependson(EcsOnUpdate)) }),
+            .query.terms = { term },
+            .callback = SetSingletons,
+            .ctx = &first,
+            .concurrent = true
+        });
+        overwrite.query.terms[i] = term;
+    }
+
+    // Systems run in creation order, so this one runs after the others
+    overwrite.entity = ecs_entity(world, { .add = ecs_ids(ecs_dependson(EcsOnUpdate)) });
+    ecs_system_init(world, &overwrite);
+
+    ecs_set_threads(world, CONCURRENT_THREADS);
+    ecs_progress(world, 0);
+
+    for (int i = 0; i < CONCURRENT_SYSTEMS; i++) {
+        const int32_t *value = ecs_get_id(world, components[i], components[i]);
+        ASSERT_TRUE(value != NULL);
+        EXPECT_EQ(*value, last);
+    }
+
+    ecs_fini(world);
+}
+
+typedef struct SortValue {
+    int32_t value;
+} SortValue;
+
+// Copy of the entity id, to check that columns move along with their entity
+typedef struct SortOwner {
+    ecs_entity_t entity;
+} SortOwner;
+
+static int CompareSortValues(ecs_entity_t e1, const void *ptr1, ecs_entity_t e2, const void *ptr2)
+{
+    (void)e1;
+    (void)e2;
+    int32_t v1 = ((const SortValue *)ptr1)->value, v2 = ((const SortValue *)ptr2)->value;
+    return (v1 > v2) - (v1 < v2);
+}
+
+static uint64_t SortValueKey(ecs_entity_t e, const void *ptr)
+{
+    (void)e;
+    return ecs_order_by_key_i64(((const SortValue *)ptr)->value);
+}
+
+static uint32_t sortSeed = 1;
+
+static int32_t sort_random(void)
+{
+    sortSeed = sortSeed * 1664525u + 1013904223u;
+    return (int32_t)(sortSeed >> 8) % 2000 - 1000;
+}
+
+// Creates SORT_ENTITIES entities with random values, every third one in a
+// second table, and a query sorted on the value
+static ecs_query_t *sort_init(ecs_world_t *world, bool byKey, ecs_entity_t *entities)
+{
+    ECS_COMPONENT(world, SortValue);
+    ECS_COMPONENT(world, SortOwner);
+    ECS_TAG(world, SortTag);
+
+    for (int i = 0; i < SORT_ENTITIES; i++) {
+        entities[i] = ecs_new(world);
+        if (i % 3 == 0) {
+            ecs_add(world, entities[i], SortTag);
+        }
+        ecs_set(world, entities[i], SortValue, { sort_random() });
+        ecs_set(world, entities[i], SortOwner, { entities[i] });
+    }
+
+    return ecs_query(world, {
+        .terms = { { ecs_id(SortValue) }, { ecs_id(SortOwner) } },
+        .order_by = ecs_id(SortValue),
+        .order_by_callback = CompareSortValues,
+        .order_by_key = byKey ? SortValueKey : NULL,
+        .cache_kind = EcsQueryCacheAuto
+    });
+}
+
+// Returns whether the query returns `count` entities in order, and whether
+// the rows, columns and entity records of the sorted tables still agree
+static bool sort_check(ecs_world_t *world, ecs_query_t *query, int32_t count)
+{
+    ecs_entity_t sortValue = ecs_lookup(world, "SortValue");
+    int32_t found = 0, last = INT32_MIN;
+    bool result = true;
+
+    ecs_iter_t it = ecs_query_iter(world, query);
+    while (ecs_query_next(&it)) {
+        const SortValue *values = ecs_field(&it, SortValue, 0);
+        const SortOwner *owners = ecs_field(&it, SortOwner, 1);
+        const ecs_entity_t *rows = ecs_table_entities(it.table);
+
+        for (int i = 0; i < it.count; i++) {
+            ecs_entity_t e = it.entities[i];
+            ecs_record_t *r = ecs_record_find(world, e);
+            int32_t row = ECS_RECORD_TO_ROW(r->row);
+
+            result &= values[i].value >= last;
+            result &= owners[i].entity == e;
+            result &= r->table == it.table && rows[row] == e;
+            result &= ecs_get_id(world, e, sortValue) == &values[i];
+            last = values[i].value;
+        }
+        found += it.count;
+    }
+
+    return result && found == count;
+}
+
+static void sort_set_values(ecs_world_t *world, ecs_entity_t *entities, int32_t step)
+{
+    ecs_entity_t sortValue = ecs_lookup(world, "SortValue");
+    for (int i = 0; i < SORT_ENTITIES; i += step) {
+        SortValue value = { sort_random() };
+        ecs_set_id(world, entities[i], sortValue, sizeof(value), &value);
+    }
+}
+
+// Tables with mostly new values take the full sort, by comparing rows or by
+// radix sorting keys
+TEST(sort, full_resort)
+{
+    for (int byKey = 0; byKey < 2; byKey++) {
+        ecs_world_t *world = ecs_init();
+        ecs_entity_t entities[SORT_ENTITIES];
+        ecs_query_t *query = sort_init(world, byKey, entities);
+
+        EXPECT_TRUE_INFO(sort_check(world, query, SORT_ENTITIES), "byKey: %d", byKey);
+
+        sort_set_values(world, entities, 1);
+        EXPECT_TRUE_INFO(sort_check(world, query, SORT_ENTITIES), "byKey: %d", byKey);
+
+        ecs_query_fini(query);
+        ecs_fini(world);
+    }
+}
+
+// Tables with a few changed values only sort the rows that are out of order
+// and merge them back into the others
+TEST(sort, partial_resort)
+{
+    for (int byKey = 0; byKey < 2; byKey++) {
+        ecs_world_t *world = ecs_init();
+        ecs_entity_t entities[SORT_ENTITIES];
+        ecs_query_t *query = sort_init(world, byKey, entities);
+        ecs_entity_t sortValue = ecs_lookup(world, "SortValue");
+        EXPECT_TRUE_INFO(sort_check(world, query, SORT_ENTITIES), "byKey: %d", byKey);
+
+        // Marked as changed, but still in order
+        ecs_modified_id(world, entities[0], sortValue);
+        EXPECT_TRUE_INFO(sort_check(world, query, SORT_ENTITIES), "byKey: %d", byKey);
+
+        sort_set_values(world, entities, SORT_ENTITIES / 8);
+        EXPECT_TRUE_INFO(sort_check(world, query, SORT_ENTITIES), "byKey: %d", byKey);
+
+        // Move the first and last rows of each table to the other end. The
+        // first two entities are in different tables.
+        ecs_entity_t firstRows[2], lastRows[2];
+        for (int t = 0; t < 2; t++) {
+            ecs_table_t *table = ecs_get_table(world, entities[t]);
+            const ecs_entity_t *rows = ecs_table_entities(table);
+            firstRows[t] = rows[0];
+            lastRows[t] = rows[ecs_table_count(table) - 1];
+        }
+        for (int t = 0; t < 2; t++) {
+            ecs_set_id(world, firstRows[t], sortValue, sizeof(SortValue), &(SortValue){ 2000 });
+            ecs_set_id(world, lastRows[t], sortValue, sizeof(SortValue), &(SortValue){ -2000 });
+        }
+        EXPECT_TRUE_INFO(sort_check(world, query, SORT_ENTITIES), "byKey: %d", byKey);
+
+        ecs_query_fini(query);
+        ecs_fini(world);
+    }
+}
+
+// Sorting permutes the rows of a table in place, after which structural
+// changes must still find each entity at its row
+TEST(sort, records_after_permute)
+{
+    for (int byKey = 0; byKey < 2; byKey++) {
+        ecs_world_t *world = ecs_init();
+        ecs_entity_t entities[SORT_ENTITIES];
+        ecs_query_t *query = sort_init(world, byKey, entities);
+        EXPECT_TRUE_INFO(sort_check(world, query, SORT_ENTITIES), "byKey: %d", byKey);
+
+        // Deleting moves the last row of the table into the deleted one
+        for (int i = 0; i < SORT_ENTITIES; i += 4) {
+            ecs_delete(world, entities[i]);
+        }
+        ecs_entity_t sortOwner = ecs_lookup(world, "SortOwner");
+        for (int i = 0; i < SORT_ENTITIES; i++) {
+            if (i % 4 == 0) {
+                EXPECT_TRUE(!ecs_is_alive(world, entities[i]));
+                continue;
+            }
+
+            const SortOwner *owner = ecs_get_id(world, entities[i], sortOwner);
+            ASSERT_TRUE(owner != NULL);
+            EXPECT_TRUE(owner->entity == entities[i]);
+        }
+        EXPECT_TRUE_INFO(sort_check(world, query, SORT_ENTITIES - SORT_ENTITIES / 4),
+                         "byKey: %d", byKey);
+
+        ecs_query_fini(query);
+        ecs_fini(world);
+    }
+}
+
+// Matching a query term against a table looks the id up in the table type.
+// Tables of every size up to TYPE_INDEX_MAX_IDS have every other id of a
+// sequence, so each lookup window and the ids past its last block of four
+// are tested with ids that are there and ids that are missing.
+TEST(query, type_index_boundaries)
+{
+    ecs_world_t *world = ecs_init();
+    ecs_entity_t ids[2 * TYPE_INDEX_MAX_IDS + 2];
+    ecs_table_t *tables[TYPE_INDEX_MAX_IDS + 1];
+
+    for (int i = 0; i < 2 * TYPE_INDEX_MAX_IDS + 2; i++) {
+        ids[i] = ecs_new(world);
+    }
+    // Low ids are looked up in the component map instead
+    ASSERT_TRUE(ids[0] >= FLECS_HI_COMPONENT_ID);
+
+    for (int count = 1; count <= TYPE_INDEX_MAX_IDS; count++) {
+        ecs_entity_t e = ecs_new(world);
+        for (int i = 1; i <= count; i++) {
+            ecs_add_id(world, e, ids[2 * i]);
+        }
+        tables[count] = ecs_get_table(world, e);
+    }
+
+    for (int i = 0; i < 2 * TYPE_INDEX_MAX_IDS + 2; i++) {
+        ecs_query_t *query = ecs_query(world, {
+            .terms = { { ids[i] } },
+            .cache_kind = EcsQueryCacheNone
+        });
+
+        for (int count = 1; count <= TYPE_INDEX_MAX_IDS; count++) {
+            bool expected = i % 2 == 0 && i >= 2 && i <= 2 * count;
+            int32_t index = ecs_table_get_type_index(world, tables[count], ids[i]);
+            ecs_iter_t it;
+            bool found = ecs_query_has_table(query, tables[count], &it);
+
+            EXPECT_TRUE_INFO(found == expected, "id: %d, table size: %d", i, count);
+            EXPECT_TRUE_INFO((index != -1) == expected, "id: %d, table size: %d", i, count);
+            if (found) {
+                EXPECT_EQ(it.trs[0]->index, index);
+                ecs_iter_fini(&it);
+            }
+        }
+
+        ecs_query_fini(query);
+    }
+
+    ecs_fini(world);
+}
+
+typedef struct CachePosition {
+    float x, y;
+} CachePosition;
+
+typedef struct CacheVelocity {
+    float x, y;
+} CacheVelocity;
+
+// Returns whether the query returns exactly the `count` expected entities
+static bool cache_matches(ecs_world_t *world, ecs_query_t *query, const ecs_entity_t *expected,
+                          int32_t count)
+{
+    int32_t found = 0;
+    bool result = true;
+
+    ecs_iter_t it = ecs_query_iter(world, query);
+    while (ecs_query_next(&it)) {
+        for (int i = 0; i < it.count; i++) {
+            bool isExpected = false;
+            for (int j = 0; j < count; j++) {
+                isExpected |= it.entities[i] == expected[j];
+            }
+            result &= isExpected;
+        }
+        found += it.count;
+    }
+
+    return result && found == count;
+}
+
+#define EXPECT_CACHE(query, ...)                                                          \
+    do {                                                                                  \
+        const ecs_entity_t expected[] = { __VA_ARGS__ };                                  \
+        EXPECT_TRUE_INFO(cache_matches(world, query, expected,                            \
+                                       (int32_t)(sizeof(expected) / sizeof(expected[0]))), \
+                         "%s", #query);                                                   \
+    } while (0)
+
+// Caches with a self only term are found through the index of the id they
+// require when a table is created, the others through their observer. The
+// caches here all exist before their tables do.
+TEST(cache, match_new_tables)
+{
+    ecs_world_t *world = ecs_init();
+    ECS_COMPONENT(world, CachePosition);
+    ECS_COMPONENT(world, CacheVelocity);
+    ECS_TAG(world, Likes);
+    ECS_TAG(world, Apples);
+    ECS_TAG(world, Rare);
+
+    ecs_query_t *both = ecs_query(world, {
+        .terms = { { ecs_id(CachePosition) }, { ecs_id(CacheVelocity) } },
+        .cache_kind = EcsQueryCacheAuto
+    });
+    ecs_query_t *likes = ecs_query(world, {
+        .terms = { { ecs_pair(Likes, EcsWildcard) } },
+        .cache_kind = EcsQueryCacheAuto
+    });
+    ecs_query_t *rare = ecs_query(world, {
+        .terms = { { ecs_id(CachePosition) }, { Rare } },
+        .cache_kind = EcsQueryCacheAuto
+    });
+    ecs_query_t *inherited = ecs_query(world, {
+        .terms = { { ecs_id(CachePosition), .src.id = EcsSelf | EcsUp, .trav = EcsChildOf } },
+        .cache_kind = EcsQueryCacheAuto
+    });
+    ecs_query_t *prefabs = ecs_query(world, {
+        .terms = { { ecs_id(CachePosition) } },
+        .cache_kind = EcsQueryCacheAuto,
+        .flags = EcsQueryMatchPrefab
+    });
+
+    ecs_entity_t moving = ecs_new(world);
+    ecs_set(world, moving, CachePosition, { 0 });
+    ecs_set(world, moving, CacheVelocity, { 0 });
+
+    ecs_entity_t liker = ecs_new_w_pair(world, Likes, Apples);
+
+    ecs_entity_t rareEntity = ecs_new_w(world, Rare);
+    ecs_set(world, rareEntity, CachePosition, { 0 });
+
+    ecs_entity_t parent = ecs_new(world);
+    ecs_set(world, parent, CachePosition, { 0 });
+    ecs_entity_t child = ecs_new_w_pair(world, EcsChildOf, parent);
+
+    // Caches don't match prefabs unless they ask for them
+    ecs_entity_t prefab = ecs_new_w_id(world, EcsPrefab);
+    ecs_set(world, prefab, CachePosition, { 0 });
+    ecs_set(world, prefab, CacheVelocity, { 0 });
+
+    EXPECT_CACHE(both, moving);
+    EXPECT_CACHE(likes, liker);
+    EXPECT_CACHE(rare, rareEntity);
+    EXPECT_CACHE(inherited, moving, rareEntity, parent, child);
+    EXPECT_CACHE(prefabs, moving, rareEntity, parent, prefab);
+
+    // A freed cache is removed from the index, the others stay in it
+    ecs_query_fini(both);
+    ecs_entity_t late = ecs_new_w_pair(world, Likes, Rare);
+    ecs_set(world, late, CachePosition, { 0 });
+    ecs_set(world, late, CacheVelocity, { 0 });
+    ecs_add(world, late, Rare);
+
+    EXPECT_CACHE(likes, liker, late);
+    EXPECT_CACHE(rare, rareEntity, late);
+    EXPECT_CACHE(prefabs, moving, rareEntity, parent, prefab, late);
+
+    ecs_query_fini(likes);
+    ecs_query_fini(rare);
+    ecs_query_fini(inherited);
+    ecs_query_fini(prefabs);
+    ecs_fini(world);
+}
+
+// A system that isn't concurrent runs on the main thread while the workers
+// wait, and must not keep them from reaching the concurrent systems
+TEST(pipeline, concurrent_after_slow_system)
+{
+    static int32_t frames[3];
+
+    ecs_world_t *world = ecs_init();
+    ecs_system(world, {
+        .entity = ecs_entity(world, { .add = ecs_ids(ecs_dependson(EcsOnUpdate)) }),
+        .callback = SleepAndCountFrames,
+        .ctx = &frames[0]
+    });
+
+    for (int i = 1; i < 3; i++) {
+        ecs_entity_t component = ecs_component_init(world, &(ecs_component_desc_t){
+            .type = { .size = sizeof(int32_t), .alignment = ECS_ALIGNOF(int32_t) }
+        });
+        ecs_system(world, {
+            .entity = ecs_entity(world, { .add = ecs_ids(ecs_dependson(EcsOnUpdate)) }),
+            .query.terms = { { .id = component, .src.id = EcsIsEntity, .inout = EcsOut } },
+            .callback = CountFrames,
+            .ctx = &frames[i],
+            .concurrent = true
+        });
+    }
+
+    ecs_set_threads(world, 2);
+    for (int i = 0; i < CONCURRENT_FRAMES; i++) {
+        ecs_progress(world, 0);
+    }
+
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(frames[i], CONCURRENT_FRAMES);
+    }
+
+    ecs_fini(world);
+}
+#endif
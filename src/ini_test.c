@@ -0,0 +1,146 @@
+#ifdef TEST
+#include <rktest/rktest.h>
+
+#include <inih/ini.h>
+
+#include <stdio.h>
+#include <string.h>
+
+// Handler calls of one parse, one "section|name|value" line per call
+typedef struct IniLog {
+    char text[8192];
+    size_t length;
+} IniLog;
+
+static void ini_log_append(IniLog *log, int sectionLength, const char *section,
+                           int nameLength, const char *name, int valueLength, const char *value)
+{
+    size_t left = sizeof(log->text) - log->length;
+    int written = snprintf(log->text + log->length, left, "%.*s|%.*s|%.*s\n",
+                           sectionLength, section, nameLength, name, valueLength, value);
+    if (written > 0) {
+        log->length += (size_t)written < left ? (size_t)written : left - 1;
+    }
+}
+
+static int ini_log_string(void *user, const char *section, const char *name, const char *value)
+{
+    ini_log_append(user, (int)strlen(section), section, (int)strlen(name), name,
+                   (int)strlen(value), value);
+    return 1;
+}
+
+static int ini_log_buffer(void *user, ini_view section, ini_view name, ini_view value)
+{
+    ini_log_append(user, (int)section.len, section.ptr, (int)name.len, name.ptr,
+                   (int)value.len, value.ptr);
+    return 1;
+}
+
+static IniLog fromString, fromBuffer;
+static int stringError, bufferError;
+
+// Parses `text` with both parsers and returns whether they made the same calls
+// and reported the same error
+static bool ini_parse_both(const char *text, size_t length)
+{
+    memset(&fromString, 0, sizeof(fromString));
+    memset(&fromBuffer, 0, sizeof(fromBuffer));
+
+    stringError = ini_parse_string_length(text, length, ini_log_string, &fromString);
+    bufferError = ini_parse_buffer(text, length, ini_log_buffer, &fromBuffer);
+
+    return stringError == bufferError && !strcmp(fromString.text, fromBuffer.text);
+}
+
+// Checks that both parsers agree on a string literal, and that
+// ini_parse_buffer() made the expected calls
+#define EXPECT_INI(input, calls)                            \
+    do {                                                    \
+        ini_parse_both(input, sizeof(input) - 1);           \
+        EXPECT_EQ(bufferError, stringError);                \
+        EXPECT_STREQ(fromBuffer.text, fromString.text);     \
+        EXPECT_STREQ(fromBuffer.text, calls);               \
+    } while (0)
+
+TEST(ini, multi_line_values)
+{
+    EXPECT_INI("[s]\na = 1\n  2\n\t3 ; comment\nb = 4\n", "s|a|1\ns|a|2\ns|a|3\ns|b|4\n");
+
+    // A repeated name on a line of its own is not a continuation
+    EXPECT_INI("a=1\na=2\n  3\n", "|a|1\n|a|2\n|a|3\n");
+
+    // Indented lines before any name and after a new section aren't either
+    EXPECT_INI("  a=1\n[s]\n  b=2\n", "|a|1\ns|b|2\n");
+}
+
+TEST(ini, inline_comments)
+{
+    EXPECT_INI("; start\n# start\n[s] ; c\na = 1 ; c\nb = x;y\nc = ;\n", "s|a|1\ns|b|x;y\ns|c|\n");
+}
+
+TEST(ini, bom)
+{
+    EXPECT_INI("\xEF\xBB\xBF[s]\na=1\n", "s|a|1\n");
+
+    // Only skipped at the start of the file
+    EXPECT_INI("a=1\n\xEF\xBB\xBF" "b=2\n", "|a|1\n|\xEF\xBB\xBF" "b|2\n");
+}
+
+TEST(ini, no_trailing_newline)
+{
+    EXPECT_INI("[s]\na=1", "s|a|1\n");
+    EXPECT_INI("[s]\r\na=1\r\nb=2\r", "s|a|1\ns|b|2\n");
+    EXPECT_INI("a=1\n  2", "|a|1\n|a|2\n");
+    EXPECT_INI("", "");
+}
+
+TEST(ini, errors)
+{
+    EXPECT_INI("[s\na=1\n", "|a|1\n");
+    EXPECT_EQ(bufferError, 1);
+    EXPECT_INI("a=1\nnovalue\nb=2\n", "|a|1\n|b|2\n");
+    EXPECT_EQ(bufferError, 2);
+    EXPECT_INI("[s]]\n[]\n=1\n:2\n", "||1\n||2\n");
+    EXPECT_EQ(bufferError, 0);
+}
+
+TEST(ini, long_lines)
+{
+    // The longest line ini_parse_string() reads whole, newline included
+    char text[4 * INI_MAX_LINE];
+    memset(text, 'v', sizeof(text));
+    memcpy(text, "a=", 2);
+    text[INI_MAX_LINE - 2] = '\n';
+    EXPECT_TRUE(ini_parse_both(text, INI_MAX_LINE - 1));
+    EXPECT_EQ(bufferError, 0);
+
+    // ini_parse_buffer() has no line limit, where ini_parse_string() stops
+    // at INI_MAX_LINE and reports the line as an error
+    text[INI_MAX_LINE - 2] = 'v';
+    IniLog log = { 0 };
+    EXPECT_EQ(ini_parse_buffer(text, sizeof(text), ini_log_buffer, &log), 0);
+    EXPECT_EQ((int)log.length, (int)sizeof(text) + 2); // "|a|" + value + '\n'
+    EXPECT_EQ(ini_parse_string_length(text, sizeof(text), ini_log_string, &(IniLog){ 0 }), 1);
+}
+
+// Random lines made of the characters the parser cares about, kept under the
+// INI_MAX_LINE and name length limits of ini_parse_string()
+TEST(ini, random_inputs)
+{
+    static const char alphabet[] = "[]=:;# \t\r\nab\n";
+    uint32_t seed = 1;
+    char text[40];
+
+    for (int i = 0; i < 20000; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        size_t length = (seed >> 8) % sizeof(text);
+        for (size_t c = 0; c < length; c++) {
+            seed = seed * 1664525u + 1013904223u;
+            text[c] = alphabet[(seed >> 8) % (sizeof(alphabet) - 1)];
+        }
+
+        ASSERT_TRUE_INFO(ini_parse_both(text, length), "input: \"%.*s\"", (int)length, text);
+    }
+}
+#endif
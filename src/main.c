@@ -1,39 +1,224 @@
 #ifndef TEST
 
 #include "raylib.h"
+#include "raymath.h"
 
-int main(void)
+#include <flecs/flecs.h>
+
+#include "config.h"
+#include "config_events.h"
+#include "fixed_step.h"
+#include "profiler.h"
+#include "render.h"
+#include "text_cache.h"
+
+#define CONFIG_PATH "config/setup.cfg"
+#define CONFIG_SNAPSHOT_PATH "config/setup.cfg.bin"
+
+#define SIM_HZ 120.0f
+#define SIM_MAX_STEPS_PER_FRAME 8
+#define TEXT_CACHE_MAX_IDLE_FRAMES 120
+#define WORKER_THREADS 4
+
+typedef struct Position {
+    float x;
+    float y;
+} Position;
+
+// Simulated angle in degrees. `previous` is the value at the start of the
+// last fixed tick, so rendering can blend between the two.
+typedef struct Rotation {
+    float value;
+    float previous;
+} Rotation;
+
+typedef struct Spin {
+    float degreesPerSecond;
+} Spin;
+
+typedef struct Label {
+    const char *text;
+    float fontSize;
+    float spacing;
+    Color color;
+} Label;
+
+// Layout of a Label for the current frame. Resolved on the main thread since
+// the text cache isn't thread safe, so worker threads only read it.
+typedef struct LabelLayout {
+    const TextLayout *layout;
+} LabelLayout;
+
+ECS_COMPONENT_DECLARE(Position);
+ECS_COMPONENT_DECLARE(Rotation);
+ECS_COMPONENT_DECLARE(Spin);
+ECS_COMPONENT_DECLARE(Label);
+ECS_COMPONENT_DECLARE(LabelLayout);
+
+static void Rotate(ecs_iter_t *it)
 {
-    const int screenWidth = 800;
-    const int screenHeight = 450;
+    Rotation *r = ecs_field(it, Rotation, 0);
+    const Spin *s = ecs_field(it, Spin, 1);
 
-    InitWindow(screenWidth, screenHeight, "raylib - rotating Hello World");
+    for (int i = 0; i < it->count; i++) {
+        r[i].previous = r[i].value;
+        r[i].value += s[i].degreesPerSecond * it->delta_time;
+    }
+}
 
-    SetTargetFPS(60);
+static void BeginFrame(ecs_iter_t *it)
+{
+    (void)it;
+    BeginDrawing();
+    ClearBackground(RAYWHITE);
+    render_begin();
+}
 
-    float rotation = 0.0f;
+static void ResolveLabels(ecs_iter_t *it)
+{
+    const Label *l = ecs_field(it, Label, 0);
+    LabelLayout *ll = ecs_field(it, LabelLayout, 1);
 
-    while (!WindowShouldClose())
-    {
-        rotation += 1.0f;
+    for (int i = 0; i < it->count; i++) {
+        ll[i].layout = text_cache_get(GetFontDefault(), l[i].text, l[i].fontSize, l[i].spacing);
+    }
+}
 
-        BeginDrawing();
-            ClearBackground(RAYWHITE);
+// Multi-threaded: each stage records into its own render queue, which are
+// merged and submitted by EndFrame on the main thread.
+static void DrawLabels(ecs_iter_t *it)
+{
+    const Label *l = ecs_field(it, Label, 0);
+    const LabelLayout *ll = ecs_field(it, LabelLayout, 1);
+    const Position *p = ecs_field(it, Position, 2);
+    const Rotation *r = ecs_field(it, Rotation, 3);
+    const FixedStep *fs = ecs_field(it, FixedStep, 4);
+    RenderQueue *queue = render_queue(ecs_stage_get_id(it->world));
 
-            const char *text = "Hello, World!";
-            int fontSize = 40;
-            Vector2 textSize = MeasureTextEx(GetFontDefault(), text, fontSize, 2);
-            Vector2 textPos = { screenWidth / 2.0f, screenHeight / 2.0f };
+    for (int i = 0; i < it->count; i++) {
+        const TextLayout *layout = ll[i].layout;
+        float rotation = Lerp(r[i].previous, r[i].value, fs->alpha);
 
-            DrawTextPro(GetFontDefault(), text, textPos,
-                        (Vector2){ textSize.x / 2, textSize.y / 2 },
-                        rotation, fontSize, 2, DARKBLUE);
-        EndDrawing();
+        render_text(queue, RENDER_STATE_DEFAULT, layout, (Vector2){ p[i].x, p[i].y },
+                    (Vector2){ layout->size.x / 2, layout->size.y / 2 },
+                    rotation, l[i].color);
     }
+}
+
+static void EndFrame(ecs_iter_t *it)
+{
+    (void)it;
+
+    ecs_os_perf_trace_push("render.flush");
+    render_flush();
+    ecs_os_perf_trace_pop("render.flush");
+
+    profiler_draw();
+    EndDrawing();
+    text_cache_trim(TEXT_CACHE_MAX_IDLE_FRAMES);
+}
+
+// Resolved to handles once at startup: timeScale is read every frame, and
+// config events compare handles instead of section/name strings.
+static const ConfigValue *timeScale;
+static const ConfigValue *targetFps;
+
+static void ApplyConfig(ecs_iter_t *it)
+{
+    const ConfigChange *change = it->param;
+
+    if (change->value == targetFps) {
+        SetTargetFPS(config_value_int(targetFps, 60));
+    }
+}
+
+// Runs the simulation catch-up first so the render systems in the builtin
+// pipeline always see the latest tick plus the interpolation factor.
+static int RunFrame(ecs_world_t *world, const ecs_app_desc_t *desc)
+{
+    (void)desc;
+
+    if (WindowShouldClose()) {
+        return 1;
+    }
+
+    if (IsKeyPressed(KEY_F3)) {
+        profiler_toggle();
+    }
+    profiler_frame(world);
+    config_events_poll(world);
+
+    float frameTime = GetFrameTime() * config_value_float(timeScale, 1.0f);
+    ecs_os_perf_trace_push("fixed_step");
+    fixed_step_advance(world, frameTime);
+    ecs_os_perf_trace_pop("fixed_step");
+
+    return !ecs_progress(world, frameTime);
+}
+
+int main(void)
+{
+    Config *config = config_load(CONFIG_PATH, CONFIG_SNAPSHOT_PATH);
+    timeScale = config_handle(config, "simulation", "timeScale");
+    targetFps = config_handle(config, "window", "fps");
+
+    const int screenWidth = config_int(config, "window", "width", 800);
+    const int screenHeight = config_int(config, "window", "height", 450);
+
+    InitWindow(screenWidth, screenHeight, config_string(config, "window", "title", "raylib - rotating Hello World"));
+
+    SetTargetFPS(config_value_int(targetFps, 60));
+
+    ecs_world_t *world = ecs_init();
+    profiler_init();
+
+    ECS_COMPONENT_DEFINE(world, Position);
+    ECS_COMPONENT_DEFINE(world, Rotation);
+    ECS_COMPONENT_DEFINE(world, Spin);
+    ECS_COMPONENT_DEFINE(world, Label);
+    ECS_COMPONENT_DEFINE(world, LabelLayout);
+    ecs_add_pair(world, ecs_id(Label), EcsWith, ecs_id(LabelLayout));
+
+    config_events_init(world, config);
+    ecs_observer(world, {
+        .query.terms = {{ ecs_id(ConfigSource) }},
+        .events = { ecs_id(ConfigChange) },
+        .callback = ApplyConfig
+    });
+
+    fixed_step_init(world, config_float(config, "simulation", "hz", SIM_HZ), SIM_MAX_STEPS_PER_FRAME);
+
+    ecs_set_threads(world, WORKER_THREADS);
+    render_init(ecs_get_stage_count(world));
+
+    ECS_SYSTEM(world, Rotate, FixedUpdate, Rotation, [in] Spin);
+    ECS_SYSTEM(world, ResolveLabels, EcsPostUpdate, [in] Label, [out] LabelLayout);
+    ECS_SYSTEM(world, BeginFrame, EcsPreStore, 0);
+    ecs_system(world, {
+        .entity = ecs_entity(world, { .name = "DrawLabels", .add = ecs_ids(ecs_dependson(EcsOnStore)) }),
+        .query.expr = "[in] Label, [in] LabelLayout, [in] Position, [in] Rotation, [in] FixedStep",
+        .callback = DrawLabels,
+        .multi_threaded = true
+    });
+    ECS_SYSTEM(world, EndFrame, EcsPostFrame, 0);
+
+    ecs_entity_t hello = ecs_new(world);
+    ecs_set(world, hello, Position, { screenWidth / 2.0f, screenHeight / 2.0f });
+    ecs_set(world, hello, Rotation, { 0.0f, 0.0f });
+    ecs_set(world, hello, Spin, { 60.0f });
+    ecs_set(world, hello, Label, { "Hello, World!", 40.0f, 2.0f, DARKBLUE });
+
+    ecs_app_set_frame_action(RunFrame);
+    ecs_app_run(world, &(ecs_app_desc_t){ 0 });
+
+    ecs_fini(world);
+    render_fini();
+    text_cache_clear();
+    config_free(config);
 
     CloseWindow();
 
     return 0;
 }
 
-#endif
\ No newline at end of file
+#endif
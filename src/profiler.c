@@ -0,0 +1,349 @@
+#include "profiler.h"
+
+#include "raylib.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROFILER_MAX_THREADS 64
+#define PROFILER_RING_SIZE 4096         // Events per thread, power of two
+#define PROFILER_MAX_DEPTH 32
+#define PROFILER_MAX_EVENTS 4096        // Events kept for the flame chart
+#define PROFILER_MAX_GROUPS 32
+#define PROFILER_MAX_SYSTEMS 256
+#define PROFILER_HISTORY 120
+
+#define PROFILER_WIDTH 420
+#define PROFILER_GRAPH_HEIGHT 60
+#define PROFILER_GRAPH_MAX_MS 33.3f
+#define PROFILER_ROW_HEIGHT 12
+#define PROFILER_ROW_DEPTH 3            // Nesting levels shown per thread
+#define PROFILER_FONT_SIZE 10
+
+#if defined(_MSC_VER)
+#define PROFILER_THREAD_LOCAL __declspec(thread)
+#else
+#define PROFILER_THREAD_LOCAL __thread
+#endif
+
+typedef struct ProfilerEvent {
+    const char *name;
+    uint64_t start;
+    uint64_t end;
+    int16_t depth;
+    int16_t thread;
+} ProfilerEvent;
+
+typedef struct ProfilerScope {
+    uint64_t start;
+    bool skip;
+} ProfilerScope;
+
+// Single producer (the owning thread), single consumer (profiler_frame)
+typedef struct ProfilerThread {
+    ProfilerEvent ring[PROFILER_RING_SIZE];
+    uint32_t head;
+    uint32_t tail;
+    int32_t depth;
+    int16_t index;
+    ProfilerScope stack[PROFILER_MAX_DEPTH];
+} ProfilerThread;
+
+typedef struct ProfilerGroup {
+    const char *name;
+    double ms;
+} ProfilerGroup;
+
+typedef struct ProfilerSystem {
+    const char *name;           // Trace name, owned by the Flecs system
+    const char *phase;          // NULL if the name isn't a system
+} ProfilerSystem;
+
+typedef struct Profiler {
+    ProfilerThread *threads[PROFILER_MAX_THREADS];
+    int32_t threadCount;
+    bool recording;
+    bool visible;
+    uint64_t frameStart;
+
+    // Last completed frame
+    uint64_t lastStart;
+    uint64_t lastEnd;
+    ProfilerEvent events[PROFILER_MAX_EVENTS];
+    int eventCount;
+    ProfilerGroup groups[PROFILER_MAX_GROUPS];
+    int groupCount;
+
+    ProfilerSystem systems[PROFILER_MAX_SYSTEMS];
+    int systemCount;
+
+    float history[PROFILER_HISTORY];
+    int historyIndex;
+} Profiler;
+
+static Profiler profiler;
+static PROFILER_THREAD_LOCAL ProfilerThread *profilerThread;
+
+static ProfilerThread *profiler_thread(void)
+{
+    if (!profilerThread) {
+        int32_t index = ecs_os_ainc(&profiler.threadCount) - 1;
+        if (index >= PROFILER_MAX_THREADS) {
+            return NULL;
+        }
+
+        profilerThread = ecs_os_calloc_t(ProfilerThread);
+        profilerThread->index = (int16_t)index;
+        profiler.threads[index] = profilerThread;
+    }
+
+    return profilerThread;
+}
+
+// Per-entity operations are traced too, but would flood the buffers
+static bool profiler_skip(const char *name)
+{
+    if (strncmp(name, "flecs.", 6) != 0) {
+        return false;
+    }
+
+    return !strcmp(name, "flecs.commit") || !strcmp(name, "flecs.emit") ||
+           !strcmp(name, "flecs.delete") || !strcmp(name, "flecs.instantiate") ||
+           !strcmp(name, "flecs.component_monitor.eval");
+}
+
+static void profiler_push(const char *file, size_t line, const char *name)
+{
+    (void)file;
+    (void)line;
+
+    if (!profiler.recording) {
+        return;
+    }
+
+    ProfilerThread *t = profiler_thread();
+    if (!t) {
+        return;
+    }
+
+    if (t->depth < PROFILER_MAX_DEPTH) {
+        ProfilerScope *s = &t->stack[t->depth];
+        s->skip = profiler_skip(name);
+        s->start = s->skip ? 0 : ecs_os_now();
+    }
+
+    t->depth++;
+}
+
+static void profiler_pop(const char *file, size_t line, const char *name)
+{
+    (void)file;
+    (void)line;
+
+    if (!profiler.recording) {
+        return;
+    }
+
+    ProfilerThread *t = profiler_thread();
+    if (!t || !t->depth) {
+        return;
+    }
+
+    t->depth--;
+    if (t->depth >= PROFILER_MAX_DEPTH || t->stack[t->depth].skip) {
+        return;
+    }
+
+    ProfilerEvent *e = &t->ring[t->head & (PROFILER_RING_SIZE - 1)];
+    e->name = name;
+    e->start = t->stack[t->depth].start;
+    e->end = ecs_os_now();
+    e->depth = (int16_t)t->depth;
+    e->thread = t->index;
+    t->head++;
+}
+
+void profiler_init(void)
+{
+    ecs_os_api.perf_trace_push_ = profiler_push;
+    ecs_os_api.perf_trace_pop_ = profiler_pop;
+}
+
+// Returns the phase of the system that produced a trace name
+static const char *profiler_phase(ecs_world_t *world, const char *name)
+{
+    for (int i = 0; i < profiler.systemCount; i++) {
+        if (profiler.systems[i].name == name) {
+            return profiler.systems[i].phase;
+        }
+    }
+
+    const char *phase = NULL;
+    ecs_entity_t e = ecs_lookup(world, name);
+    if (e && ecs_has_pair(world, e, ecs_id(EcsPoly), EcsSystem)) {
+        ecs_entity_t dependsOn = ecs_get_target(world, e, EcsDependsOn, 0);
+        phase = dependsOn ? ecs_get_name(world, dependsOn) : "(manual)";
+    }
+
+    if (profiler.systemCount < PROFILER_MAX_SYSTEMS) {
+        profiler.systems[profiler.systemCount++] = (ProfilerSystem){ name, phase };
+    }
+
+    return phase;
+}
+
+static void profiler_accumulate(const char *group, double ms)
+{
+    for (int i = 0; i < profiler.groupCount; i++) {
+        if (!strcmp(profiler.groups[i].name, group)) {
+            profiler.groups[i].ms += ms;
+            return;
+        }
+    }
+
+    if (profiler.groupCount < PROFILER_MAX_GROUPS) {
+        profiler.groups[profiler.groupCount++] = (ProfilerGroup){ group, ms };
+    }
+}
+
+void profiler_frame(ecs_world_t *world)
+{
+    uint64_t now = ecs_os_now();
+
+    if (profiler.recording) {
+        profiler.lastStart = profiler.frameStart;
+        profiler.lastEnd = now;
+        profiler.eventCount = 0;
+        profiler.groupCount = 0;
+
+        int32_t threadCount = profiler.threadCount;
+        if (threadCount > PROFILER_MAX_THREADS) {
+            threadCount = PROFILER_MAX_THREADS;
+        }
+
+        for (int32_t i = 0; i < threadCount; i++) {
+            ProfilerThread *t = profiler.threads[i];
+            if (!t) {
+                continue;
+            }
+
+            uint32_t head = t->head;
+            if (head - t->tail > PROFILER_RING_SIZE) {
+                t->tail = head - PROFILER_RING_SIZE;  // Overrun, oldest events are gone
+            }
+
+            for (; t->tail != head; t->tail++) {
+                const ProfilerEvent *e = &t->ring[t->tail & (PROFILER_RING_SIZE - 1)];
+                double ms = (double)(e->end - e->start) / 1000000.0;
+
+                if (profiler.eventCount < PROFILER_MAX_EVENTS) {
+                    profiler.events[profiler.eventCount++] = *e;
+                }
+
+                const char *phase = profiler_phase(world, e->name);
+                if (phase) {
+                    profiler_accumulate(phase, ms);
+                } else if (!strcmp(e->name, "flecs.commands.merge")) {
+                    profiler_accumulate("(merge)", ms);
+                }
+            }
+        }
+
+        profiler.history[profiler.historyIndex] = (float)((double)(now - profiler.frameStart) / 1000000.0);
+        profiler.historyIndex = (profiler.historyIndex + 1) % PROFILER_HISTORY;
+    }
+
+    // Only flipped here, while no thread is inside a traced scope
+    profiler.recording = profiler.visible;
+    profiler.frameStart = now;
+}
+
+void profiler_toggle(void)
+{
+    profiler.visible = !profiler.visible;
+}
+
+bool profiler_visible(void)
+{
+    return profiler.visible;
+}
+
+static Color profiler_color(const char *name)
+{
+    uint32_t h = 2166136261u;
+    for (; *name; name++) {
+        h = (h ^ (unsigned char)*name) * 16777619u;
+    }
+
+    return (Color){ (unsigned char)(96 + (h & 0x7f)), (unsigned char)(96 + ((h >> 8) & 0x7f)),
+                    (unsigned char)(96 + ((h >> 16) & 0x7f)), 255 };
+}
+
+void profiler_draw(void)
+{
+    if (!profiler.visible) {
+        return;
+    }
+
+    int threadCount = profiler.threadCount < PROFILER_MAX_THREADS ? profiler.threadCount : PROFILER_MAX_THREADS;
+    int x = 10;
+    int y = 10;
+    int height = PROFILER_GRAPH_HEIGHT + 20 + profiler.groupCount * PROFILER_ROW_HEIGHT +
+                 threadCount * PROFILER_ROW_DEPTH * PROFILER_ROW_HEIGHT + 20;
+
+    DrawRectangle(x - 5, y - 5, PROFILER_WIDTH + 10, height, Fade(BLACK, 0.75f));
+
+    // Rolling frame time graph, oldest frame on the left
+    float barWidth = (float)PROFILER_WIDTH / PROFILER_HISTORY;
+    for (int i = 0; i < PROFILER_HISTORY; i++) {
+        float ms = profiler.history[(profiler.historyIndex + i) % PROFILER_HISTORY];
+        float h = ms / PROFILER_GRAPH_MAX_MS * PROFILER_GRAPH_HEIGHT;
+        if (h > PROFILER_GRAPH_HEIGHT) {
+            h = PROFILER_GRAPH_HEIGHT;
+        }
+
+        Color color = (ms > PROFILER_GRAPH_MAX_MS) ? RED : (ms > PROFILER_GRAPH_MAX_MS / 2) ? YELLOW : GREEN;
+        DrawRectangle(x + (int)(i * barWidth), y + PROFILER_GRAPH_HEIGHT - (int)h,
+                      (int)barWidth > 1 ? (int)barWidth - 1 : 1, (int)h, color);
+    }
+
+    int budgetY = y + PROFILER_GRAPH_HEIGHT / 2;
+    DrawLine(x, budgetY, x + PROFILER_WIDTH, budgetY, Fade(WHITE, 0.5f));
+    y += PROFILER_GRAPH_HEIGHT + 4;
+
+    double frameMs = (double)(profiler.lastEnd - profiler.lastStart) / 1000000.0;
+    DrawText(TextFormat("frame %.2f ms (%d fps)", frameMs, GetFPS()), x, y, PROFILER_FONT_SIZE, WHITE);
+    y += 16;
+
+    for (int i = 0; i < profiler.groupCount; i++) {
+        DrawText(TextFormat("%-16s %7.3f ms", profiler.groups[i].name, profiler.groups[i].ms),
+                 x, y, PROFILER_FONT_SIZE, LIGHTGRAY);
+        y += PROFILER_ROW_HEIGHT;
+    }
+    y += 4;
+
+    // Flame chart of the last frame, one band per thread
+    double frameNs = (double)(profiler.lastEnd - profiler.lastStart);
+    if (frameNs <= 0.0) {
+        return;
+    }
+
+    for (int i = 0; i < profiler.eventCount; i++) {
+        const ProfilerEvent *e = &profiler.events[i];
+        if (e->depth >= PROFILER_ROW_DEPTH || e->start < profiler.lastStart) {
+            continue;
+        }
+
+        int ex = x + (int)((double)(e->start - profiler.lastStart) / frameNs * PROFILER_WIDTH);
+        int ew = (int)((double)(e->end - e->start) / frameNs * PROFILER_WIDTH);
+        int ey = y + (e->thread * PROFILER_ROW_DEPTH + e->depth) * PROFILER_ROW_HEIGHT;
+        if (ew < 1) {
+            ew = 1;
+        }
+
+        DrawRectangle(ex, ey, ew, PROFILER_ROW_HEIGHT - 1, profiler_color(e->name));
+        if (ew > 40) {
+            DrawText(e->name, ex + 2, ey + 1, PROFILER_FONT_SIZE, BLACK);
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+
+#include <flecs/flecs.h>
+
+// In-app frame profiler.
+//
+// Hooks the Flecs perf trace callbacks (requires FLECS_PERF_TRACE) so every
+// system run and command merge is timed, plus any scope the application
+// marks with ecs_os_perf_trace_push()/ecs_os_perf_trace_pop(). Each thread
+// writes into its own ring buffer; the main thread drains them once per frame
+// while the workers are parked, so recording takes no locks.
+//
+// Nothing is recorded while the overlay is hidden, leaving only the cost of
+// the hook checking a flag.
+
+// Installs the trace hooks. Call after ecs_init().
+void profiler_init(void);
+
+// Closes the previous frame and starts a new one. Must be called on the main
+// thread outside of ecs_progress(), once per frame.
+void profiler_frame(ecs_world_t *world);
+
+// Visibility changes take effect at the next profiler_frame().
+void profiler_toggle(void);
+bool profiler_visible(void);
+
+// Draws the overlay for the last completed frame. Must be called between
+// BeginDrawing() and EndDrawing().
+void profiler_draw(void);
+
+#endif
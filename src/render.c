@@ -0,0 +1,311 @@
+#include "render.h"
+
+#include "rlgl.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum RenderCommandKind {
+    RENDER_COMMAND_SPRITE,
+    RENDER_COMMAND_RECT,
+    RENDER_COMMAND_TEXT,
+} RenderCommandKind;
+
+typedef struct RenderCommand {
+    // Sort key
+    int layer;
+    unsigned int shaderId;
+    int blendMode;
+    unsigned int textureId;
+    int queue;
+    int sequence;
+
+    RenderCommandKind kind;
+    int *shaderLocs;
+    Vector2 position;
+    Vector2 origin;
+    float rotation;
+    Color tint;
+    union {
+        struct {
+            Rectangle uv;       // u0, v0, u1, v1
+            Vector2 size;
+        } quad;
+        const TextLayout *layout;
+    } data;
+} RenderCommand;
+
+struct RenderQueue {
+    RenderCommand *commands;
+    int count;
+    int capacity;
+    int index;
+    // Keeps queues written by different threads on separate cache lines
+    char padding[64];
+};
+
+typedef struct Renderer {
+    RenderQueue *queues;
+    int queueCount;
+    RenderCommand *merged;      // All queues, concatenated for sorting
+    int count;
+    int capacity;
+    int batches;
+} Renderer;
+
+static Renderer renderer;
+
+static RenderCommand *render_push(RenderQueue *queue, RenderState state, RenderCommandKind kind, unsigned int textureId)
+{
+    if (queue->count == queue->capacity) {
+        queue->capacity = queue->capacity ? queue->capacity * 2 : 256;
+        queue->commands = realloc(queue->commands, (size_t)queue->capacity * sizeof(RenderCommand));
+    }
+
+    RenderCommand *cmd = &queue->commands[queue->count];
+    cmd->layer = state.layer;
+    cmd->shaderId = state.shader.id;
+    cmd->shaderLocs = state.shader.locs;
+    cmd->blendMode = state.blendMode;
+    cmd->textureId = textureId;
+    cmd->queue = queue->index;
+    cmd->sequence = queue->count;
+    cmd->kind = kind;
+    queue->count++;
+
+    return cmd;
+}
+
+void render_init(int queueCount)
+{
+    render_fini();
+
+    renderer.queues = calloc((size_t)queueCount, sizeof(RenderQueue));
+    renderer.queueCount = queueCount;
+    for (int i = 0; i < queueCount; i++) {
+        renderer.queues[i].index = i;
+    }
+}
+
+RenderQueue *render_queue(int index)
+{
+    return &renderer.queues[index];
+}
+
+void render_begin(void)
+{
+    for (int i = 0; i < renderer.queueCount; i++) {
+        renderer.queues[i].count = 0;
+    }
+}
+
+void render_sprite(RenderQueue *queue, RenderState state, Texture2D texture,
+                   Rectangle source, Rectangle dest, Vector2 origin, float rotation, Color tint)
+{
+    if (texture.id == 0) {
+        return;
+    }
+
+    RenderCommand *cmd = render_push(queue, state, RENDER_COMMAND_SPRITE, texture.id);
+    float w = (float)texture.width;
+    float h = (float)texture.height;
+
+    cmd->position = (Vector2){ dest.x, dest.y };
+    cmd->origin = origin;
+    cmd->rotation = rotation;
+    cmd->tint = tint;
+    cmd->data.quad.uv = (Rectangle){
+        source.x / w, source.y / h,
+        (source.x + source.width) / w, (source.y + source.height) / h
+    };
+    cmd->data.quad.size = (Vector2){ dest.width, dest.height };
+}
+
+void render_rect(RenderQueue *queue, RenderState state, Rectangle rec,
+                 Vector2 origin, float rotation, Color color)
+{
+    RenderCommand *cmd = render_push(queue, state, RENDER_COMMAND_RECT, rlGetTextureIdDefault());
+
+    cmd->position = (Vector2){ rec.x, rec.y };
+    cmd->origin = origin;
+    cmd->rotation = rotation;
+    cmd->tint = color;
+    cmd->data.quad.uv = (Rectangle){ 0.0f, 0.0f, 1.0f, 1.0f };
+    cmd->data.quad.size = (Vector2){ rec.width, rec.height };
+}
+
+void render_text(RenderQueue *queue, RenderState state, const TextLayout *layout,
+                 Vector2 position, Vector2 origin, float rotation, Color tint)
+{
+    if (!layout->quadCount) {
+        return;
+    }
+
+    RenderCommand *cmd = render_push(queue, state, RENDER_COMMAND_TEXT, layout->textureId);
+
+    cmd->position = position;
+    cmd->origin = origin;
+    cmd->rotation = rotation;
+    cmd->tint = tint;
+    cmd->data.layout = layout;
+}
+
+static int render_compare(const void *lhs, const void *rhs)
+{
+    const RenderCommand *a = lhs;
+    const RenderCommand *b = rhs;
+
+    // Shader and blend changes flush the whole rlgl batch, while a texture
+    // change only starts a new draw call inside it, so they sort first.
+    if (a->layer != b->layer) return (a->layer < b->layer) ? -1 : 1;
+    if (a->shaderId != b->shaderId) return (a->shaderId < b->shaderId) ? -1 : 1;
+    if (a->blendMode != b->blendMode) return (a->blendMode < b->blendMode) ? -1 : 1;
+    if (a->textureId != b->textureId) return (a->textureId < b->textureId) ? -1 : 1;
+    if (a->queue != b->queue) return a->queue - b->queue;
+    return a->sequence - b->sequence;
+}
+
+// Emits one quad given in the command's local space (origin already applied)
+static void render_emit_quad(Vector2 position, float c, float s, Rectangle local, Rectangle uv)
+{
+    float x0 = local.x;
+    float y0 = local.y;
+    float x1 = local.x + local.width;
+    float y1 = local.y + local.height;
+
+    rlTexCoord2f(uv.x, uv.y);
+    rlVertex2f(position.x + x0 * c - y0 * s, position.y + x0 * s + y0 * c);
+    rlTexCoord2f(uv.x, uv.height);
+    rlVertex2f(position.x + x0 * c - y1 * s, position.y + x0 * s + y1 * c);
+    rlTexCoord2f(uv.width, uv.height);
+    rlVertex2f(position.x + x1 * c - y1 * s, position.y + x1 * s + y1 * c);
+    rlTexCoord2f(uv.width, uv.y);
+    rlVertex2f(position.x + x1 * c - y0 * s, position.y + x1 * s + y0 * c);
+}
+
+static void render_emit(const RenderCommand *cmd)
+{
+    float c = 1.0f;
+    float s = 0.0f;
+
+    if (cmd->rotation != 0.0f) {
+        float radians = cmd->rotation * (PI / 180.0f);
+        c = cosf(radians);
+        s = sinf(radians);
+    }
+
+    rlColor4ub(cmd->tint.r, cmd->tint.g, cmd->tint.b, cmd->tint.a);
+
+    if (cmd->kind == RENDER_COMMAND_TEXT) {
+        const TextLayout *layout = cmd->data.layout;
+        rlCheckRenderBatchLimit(4 * layout->quadCount);
+
+        for (int i = 0; i < layout->quadCount; i++) {
+            const TextGlyphQuad *q = &layout->quads[i];
+            Rectangle local = {
+                q->dst.x - cmd->origin.x, q->dst.y - cmd->origin.y,
+                q->dst.width, q->dst.height
+            };
+            render_emit_quad(cmd->position, c, s, local, (Rectangle){ q->u0, q->v0, q->u1, q->v1 });
+        }
+    } else {
+        Rectangle local = {
+            -cmd->origin.x, -cmd->origin.y,
+            cmd->data.quad.size.x, cmd->data.quad.size.y
+        };
+        rlCheckRenderBatchLimit(4);
+        render_emit_quad(cmd->position, c, s, local, cmd->data.quad.uv);
+    }
+}
+
+static void render_merge(void)
+{
+    int count = 0;
+    for (int i = 0; i < renderer.queueCount; i++) {
+        count += renderer.queues[i].count;
+    }
+
+    if (count > renderer.capacity) {
+        renderer.capacity = count;
+        renderer.merged = realloc(renderer.merged, (size_t)count * sizeof(RenderCommand));
+    }
+
+    renderer.count = 0;
+    for (int i = 0; i < renderer.queueCount; i++) {
+        const RenderQueue *queue = &renderer.queues[i];
+        if (queue->count) {
+            memcpy(&renderer.merged[renderer.count], queue->commands,
+                   (size_t)queue->count * sizeof(RenderCommand));
+            renderer.count += queue->count;
+        }
+    }
+}
+
+void render_flush(void)
+{
+    renderer.batches = 0;
+    render_merge();
+    if (!renderer.count) {
+        return;
+    }
+
+    qsort(renderer.merged, (size_t)renderer.count, sizeof(RenderCommand), render_compare);
+
+    const RenderCommand *run = NULL;
+    for (int i = 0; i < renderer.count; i++) {
+        const RenderCommand *cmd = &renderer.merged[i];
+
+        bool stateChanged = !run || cmd->shaderId != run->shaderId || cmd->blendMode != run->blendMode;
+        bool textureChanged = !run || cmd->textureId != run->textureId;
+
+        if (run && (stateChanged || textureChanged)) {
+            rlEnd();
+        }
+
+        if (stateChanged) {
+            if (run && run->shaderId) EndShaderMode();
+            if (run && run->blendMode != BLEND_ALPHA) EndBlendMode();
+
+            if (cmd->shaderId) BeginShaderMode((Shader){ cmd->shaderId, cmd->shaderLocs });
+            if (cmd->blendMode != BLEND_ALPHA) BeginBlendMode(cmd->blendMode);
+        }
+
+        if (stateChanged || textureChanged) {
+            rlSetTexture(cmd->textureId);
+            rlBegin(RL_QUADS);
+            rlNormal3f(0.0f, 0.0f, 1.0f);
+            run = cmd;
+            renderer.batches++;
+        }
+
+        render_emit(cmd);
+    }
+
+    rlEnd();
+    rlSetTexture(0);
+
+    if (run->shaderId) EndShaderMode();
+    if (run->blendMode != BLEND_ALPHA) EndBlendMode();
+}
+
+int render_command_count(void)
+{
+    return renderer.count;
+}
+
+int render_batch_count(void)
+{
+    return renderer.batches;
+}
+
+void render_fini(void)
+{
+    for (int i = 0; i < renderer.queueCount; i++) {
+        free(renderer.queues[i].commands);
+    }
+
+    free(renderer.queues);
+    free(renderer.merged);
+    renderer = (Renderer){ 0 };
+}
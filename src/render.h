@@ -0,0 +1,66 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "raylib.h"
+
+#include "text_cache.h"
+
+// Retained batching layer over rlgl.
+//
+// Instead of drawing immediately, systems submit commands into a per-frame
+// buffer. render_flush() sorts the buffer by (layer, shader, blend mode,
+// texture) and emits every run of commands that share that state as one
+// rlBegin(RL_QUADS)/rlEnd() block, so state changes (and the draw calls they
+// cause) happen once per run instead of once per command. Commands with equal
+// state keep their submission order.
+//
+// Recording is split over one queue per Flecs stage so multi-threaded systems
+// can submit without locking; only render_flush() talks to rlgl, and it must
+// run on the thread that owns the GL context.
+//
+//      RenderQueue *queue = render_queue(ecs_stage_get_id(it->world));
+//      render_sprite(queue, state, texture, src, dst, origin, 0.0f, WHITE);
+//      render_text(queue, state, layout, position, origin, rotation, BLACK);
+//
+// All submitted pointers (text layouts) must stay valid until render_flush().
+
+typedef struct RenderQueue RenderQueue;
+
+typedef struct RenderState {
+    int layer;                  // Lower layers are drawn first
+    Shader shader;              // id 0 uses the default shader
+    int blendMode;              // BlendMode value
+} RenderState;
+
+#define RENDER_STATE_DEFAULT ((RenderState){ 0 })
+
+// Allocates one queue per recording thread, typically ecs_get_stage_count().
+void render_init(int queueCount);
+
+// Queue to record into from the thread with the given stage id.
+RenderQueue *render_queue(int index);
+
+// Clears all queues. Call once per frame before submitting.
+void render_begin(void);
+
+void render_sprite(RenderQueue *queue, RenderState state, Texture2D texture,
+                   Rectangle source, Rectangle dest, Vector2 origin, float rotation, Color tint);
+
+void render_rect(RenderQueue *queue, RenderState state, Rectangle rec,
+                 Vector2 origin, float rotation, Color color);
+
+void render_text(RenderQueue *queue, RenderState state, const TextLayout *layout,
+                 Vector2 position, Vector2 origin, float rotation, Color tint);
+
+// Merges the queues, sorts and draws all submitted commands. Must be called
+// between BeginDrawing() and EndDrawing(), with no recording in progress.
+void render_flush(void);
+
+// Number of commands and state runs of the last flush.
+int render_command_count(void);
+int render_batch_count(void);
+
+// Frees all queues.
+void render_fini(void);
+
+#endif
@@ -0,0 +1,234 @@
+#include "text_cache.h"
+
+#include "rlgl.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// raylib doesn't expose the value set by SetTextLineSpacing(), so layouts use
+// its default. Only matters for text containing '\n'.
+#define TEXT_CACHE_LINE_SPACING 2.0f
+
+#define TEXT_CACHE_INITIAL_BUCKETS 64
+
+typedef struct TextCacheEntry {
+    struct TextCacheEntry *next;
+    uint64_t hash;
+    unsigned int textureId;
+    int baseSize;
+    float fontSize;
+    float spacing;
+    uint64_t lastUsed;
+    TextLayout layout;
+    char text[];
+} TextCacheEntry;
+
+typedef struct TextCache {
+    TextCacheEntry **buckets;
+    int bucketCount;            // Always a power of two
+    int count;
+    uint64_t frame;
+} TextCache;
+
+static TextCache cache;
+
+static uint64_t text_cache_hash(Font font, const char *text, size_t length, float fontSize, float spacing)
+{
+    // FNV-1a over the string, then mixed with the remaining key fields
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        h ^= (unsigned char)text[i];
+        h *= 1099511628211ULL;
+    }
+
+    uint32_t bits[4] = { font.texture.id, (uint32_t)font.baseSize, 0, 0 };
+    memcpy(&bits[2], &fontSize, sizeof(float));
+    memcpy(&bits[3], &spacing, sizeof(float));
+    for (int i = 0; i < 4; i++) {
+        h ^= bits[i];
+        h *= 1099511628211ULL;
+    }
+
+    return h;
+}
+
+static void text_cache_grow(void)
+{
+    int bucketCount = cache.bucketCount ? cache.bucketCount * 2 : TEXT_CACHE_INITIAL_BUCKETS;
+    TextCacheEntry **buckets = calloc((size_t)bucketCount, sizeof(TextCacheEntry *));
+
+    for (int b = 0; b < cache.bucketCount; b++) {
+        TextCacheEntry *e = cache.buckets[b];
+        while (e) {
+            TextCacheEntry *next = e->next;
+            TextCacheEntry **slot = &buckets[e->hash & (uint64_t)(bucketCount - 1)];
+            e->next = *slot;
+            *slot = e;
+            e = next;
+        }
+    }
+
+    free(cache.buckets);
+    cache.buckets = buckets;
+    cache.bucketCount = bucketCount;
+}
+
+// Mirrors the glyph placement of DrawTextEx()/DrawTextCodepoint()
+static void text_cache_layout(TextLayout *layout, Font font, const char *text, float fontSize, float spacing)
+{
+    float scaleFactor = fontSize / (float)font.baseSize;
+    float padding = (float)font.glyphPadding;
+    float invWidth = font.texture.width ? 1.0f / (float)font.texture.width : 0.0f;
+    float invHeight = font.texture.height ? 1.0f / (float)font.texture.height : 0.0f;
+    float offsetX = 0.0f;
+    float offsetY = 0.0f;
+
+    layout->size = MeasureTextEx(font, text, fontSize, spacing);
+    layout->textureId = font.texture.id;
+    layout->quadCount = 0;
+    layout->quads = malloc(strlen(text) * sizeof(TextGlyphQuad));
+
+    for (int i = 0; text[i] != '\0';) {
+        int codepointByteCount = 0;
+        int codepoint = GetCodepointNext(&text[i], &codepointByteCount);
+        int index = GetGlyphIndex(font, codepoint);
+        i += codepointByteCount;
+
+        if (codepoint == '\n') {
+            offsetY += fontSize + TEXT_CACHE_LINE_SPACING;
+            offsetX = 0.0f;
+            continue;
+        }
+
+        Rectangle rec = font.recs[index];
+        GlyphInfo glyph = font.glyphs[index];
+
+        if ((codepoint != ' ') && (codepoint != '\t')) {
+            TextGlyphQuad *q = &layout->quads[layout->quadCount++];
+            q->dst = (Rectangle){
+                offsetX + glyph.offsetX * scaleFactor - padding * scaleFactor,
+                offsetY + glyph.offsetY * scaleFactor - padding * scaleFactor,
+                (rec.width + 2.0f * padding) * scaleFactor,
+                (rec.height + 2.0f * padding) * scaleFactor
+            };
+            q->u0 = (rec.x - padding) * invWidth;
+            q->v0 = (rec.y - padding) * invHeight;
+            q->u1 = (rec.x + rec.width + padding) * invWidth;
+            q->v1 = (rec.y + rec.height + padding) * invHeight;
+        }
+
+        if (glyph.advanceX == 0) {
+            offsetX += rec.width * scaleFactor + spacing;
+        } else {
+            offsetX += glyph.advanceX * scaleFactor + spacing;
+        }
+    }
+}
+
+const TextLayout *text_cache_get(Font font, const char *text, float fontSize, float spacing)
+{
+    size_t length = strlen(text);
+    uint64_t hash = text_cache_hash(font, text, length, fontSize, spacing);
+
+    if (cache.bucketCount) {
+        TextCacheEntry *e = cache.buckets[hash & (uint64_t)(cache.bucketCount - 1)];
+        for (; e; e = e->next) {
+            if (e->hash == hash && e->textureId == font.texture.id &&
+                e->baseSize == font.baseSize && e->fontSize == fontSize &&
+                e->spacing == spacing && strcmp(e->text, text) == 0) {
+                e->lastUsed = cache.frame;
+                return &e->layout;
+            }
+        }
+    }
+
+    if (cache.count >= cache.bucketCount) {
+        text_cache_grow();
+    }
+
+    TextCacheEntry *e = malloc(sizeof(TextCacheEntry) + length + 1);
+    e->hash = hash;
+    e->textureId = font.texture.id;
+    e->baseSize = font.baseSize;
+    e->fontSize = fontSize;
+    e->spacing = spacing;
+    e->lastUsed = cache.frame;
+    memcpy(e->text, text, length + 1);
+    text_cache_layout(&e->layout, font, text, fontSize, spacing);
+
+    TextCacheEntry **slot = &cache.buckets[hash & (uint64_t)(cache.bucketCount - 1)];
+    e->next = *slot;
+    *slot = e;
+    cache.count++;
+
+    return &e->layout;
+}
+
+void text_layout_draw(const TextLayout *layout, Vector2 position, Vector2 origin, float rotation, Color tint)
+{
+    if (!layout->quadCount) {
+        return;
+    }
+
+    rlPushMatrix();
+        rlTranslatef(position.x, position.y, 0.0f);
+        rlRotatef(rotation, 0.0f, 0.0f, 1.0f);
+        rlTranslatef(-origin.x, -origin.y, 0.0f);
+
+        rlCheckRenderBatchLimit(4 * layout->quadCount);
+        rlSetTexture(layout->textureId);
+        rlBegin(RL_QUADS);
+            rlColor4ub(tint.r, tint.g, tint.b, tint.a);
+            rlNormal3f(0.0f, 0.0f, 1.0f);
+
+            for (int i = 0; i < layout->quadCount; i++) {
+                const TextGlyphQuad *q = &layout->quads[i];
+                float x1 = q->dst.x + q->dst.width;
+                float y1 = q->dst.y + q->dst.height;
+
+                rlTexCoord2f(q->u0, q->v0); rlVertex2f(q->dst.x, q->dst.y);
+                rlTexCoord2f(q->u0, q->v1); rlVertex2f(q->dst.x, y1);
+                rlTexCoord2f(q->u1, q->v1); rlVertex2f(x1, y1);
+                rlTexCoord2f(q->u1, q->v0); rlVertex2f(x1, q->dst.y);
+            }
+        rlEnd();
+        rlSetTexture(0);
+    rlPopMatrix();
+}
+
+void text_cache_trim(int maxIdleFrames)
+{
+    for (int b = 0; b < cache.bucketCount; b++) {
+        TextCacheEntry **slot = &cache.buckets[b];
+        while (*slot) {
+            TextCacheEntry *e = *slot;
+            if (cache.frame - e->lastUsed > (uint64_t)maxIdleFrames) {
+                *slot = e->next;
+                free(e->layout.quads);
+                free(e);
+                cache.count--;
+            } else {
+                slot = &e->next;
+            }
+        }
+    }
+
+    cache.frame++;
+}
+
+void text_cache_clear(void)
+{
+    for (int b = 0; b < cache.bucketCount; b++) {
+        TextCacheEntry *e = cache.buckets[b];
+        while (e) {
+            TextCacheEntry *next = e->next;
+            free(e->layout.quads);
+            free(e);
+            e = next;
+        }
+    }
+
+    free(cache.buckets);
+    cache = (TextCache){ 0 };
+}
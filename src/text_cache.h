@@ -0,0 +1,45 @@
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+#include "raylib.h"
+
+// Text layout cache.
+//
+// Measuring and laying out a string with MeasureTextEx/DrawTextPro decodes
+// every codepoint and looks up every glyph each time it is drawn. The cache
+// does that work once per (font, text, fontSize, spacing) and keeps the
+// resulting extents and glyph quads until the entry stops being requested.
+//
+//      const TextLayout *layout = text_cache_get(font, "Score", 20, 1);
+//      text_layout_draw(layout, position, origin, 0.0f, BLACK);
+//
+// Layouts are owned by the cache; a pointer stays valid until the entry is
+// evicted by text_cache_trim() or the cache is cleared.
+
+typedef struct TextGlyphQuad {
+    Rectangle dst;              // Relative to the top-left of the text
+    float u0, v0, u1, v1;       // Normalized texture coordinates
+} TextGlyphQuad;
+
+typedef struct TextLayout {
+    Vector2 size;               // Same as MeasureTextEx()
+    unsigned int textureId;
+    int quadCount;
+    TextGlyphQuad *quads;
+} TextLayout;
+
+// Returns the layout for the given inputs, building it on first use.
+const TextLayout *text_cache_get(Font font, const char *text, float fontSize, float spacing);
+
+// Draws a layout with the same position/origin/rotation semantics as
+// DrawTextPro().
+void text_layout_draw(const TextLayout *layout, Vector2 position, Vector2 origin, float rotation, Color tint);
+
+// Advances the cache frame counter and evicts entries that were not requested
+// during the last `maxIdleFrames` frames. Call once per frame.
+void text_cache_trim(int maxIdleFrames);
+
+// Frees all entries. Must be called before the fonts they refer to unload.
+void text_cache_clear(void);
+
+#endif